@@ -0,0 +1,89 @@
+// Copyright (c) 2024 Rasna Studios. All rights reserved.
+
+#include "Benchmark/BenchmarkBotController.h"
+
+#include "EngineUtils.h"
+#include "GameFramework/Character.h"
+#include "GameFramework/GameModeBase.h"
+
+static FAutoConsoleCommandWithWorldAndArgs GSpawnBotsCommand(TEXT("OpenShooter.Bench.SpawnBots"),
+    TEXT("Spawns <Count> benchmark bots on the server (default 31)"),
+    FConsoleCommandWithWorldAndArgsDelegate::CreateLambda(
+        [](const TArray<FString>& Args, UWorld* World)
+        { ABenchmarkBotController::SpawnBots(World, Args.Num() > 0 ? FCString::Atoi(*Args[0]) : 31); }));
+
+static FAutoConsoleCommandWithWorld GRemoveBotsCommand(TEXT("OpenShooter.Bench.RemoveBots"),
+    TEXT("Destroys all the benchmark bots and their characters"),
+    FConsoleCommandWithWorldDelegate::CreateLambda([](UWorld* World) { ABenchmarkBotController::RemoveBots(World); }));
+
+ABenchmarkBotController::ABenchmarkBotController()
+{
+    PrimaryActorTick.bCanEverTick = true;
+    bWantsPlayerState = true;    // bots show up in the player states like real players
+}
+
+void ABenchmarkBotController::PostInitializeComponents()
+{
+    Super::PostInitializeComponents();
+
+    if (HasAuthority())
+        InitPlayerState();
+}
+
+void ABenchmarkBotController::Tick(const float DeltaSeconds)
+{
+    Super::Tick(DeltaSeconds);
+
+    ACharacter* Bot = Cast<ACharacter>(GetPawn());
+    if (Bot == nullptr)
+        return;
+
+    TimeToNextTurn -= DeltaSeconds;
+    if (TimeToNextTurn <= 0.f)
+    {
+        TimeToNextTurn = FMath::FRandRange(TurnInterval.X, TurnInterval.Y);
+        WanderDirection = FRotator(0.f, FMath::FRandRange(0.f, 360.f), 0.f).Vector();
+        SetControlRotation(WanderDirection.Rotation());
+        if (FMath::FRand() < JumpChance)
+            Bot->Jump();
+    }
+    Bot->AddMovementInput(WanderDirection);
+}
+
+void ABenchmarkBotController::SpawnBots(UWorld* World, const int32 Count)
+{
+    AGameModeBase* GameMode = World ? World->GetAuthGameMode() : nullptr;
+    if (GameMode == nullptr)
+    {
+        UE_LOG(LogTemp, Warning, TEXT("Benchmark bots can only be spawned on the server"));
+        return;
+    }
+
+    for (int32 i = 0; i < Count; ++i)
+    {
+        ABenchmarkBotController* Bot = World->SpawnActor<ABenchmarkBotController>();
+        const AActor* Start = GameMode->ChoosePlayerStart(Bot);
+        const FVector Offset(FMath::FRandRange(-300.f, 300.f), FMath::FRandRange(-300.f, 300.f), 0.f);
+        const FTransform SpawnTransform(Start ? Start->GetActorRotation() : FRotator::ZeroRotator,
+            (Start ? Start->GetActorLocation() : FVector::ZeroVector) + Offset);
+
+        FActorSpawnParameters SpawnParams;
+        SpawnParams.SpawnCollisionHandlingOverride = ESpawnActorCollisionHandlingMethod::AdjustIfPossibleButAlwaysSpawn;
+        APawn* Pawn = World->SpawnActor<APawn>(GameMode->GetDefaultPawnClassForController(Bot), SpawnTransform, SpawnParams);
+        if (Pawn)
+            Bot->Possess(Pawn);
+    }
+    UE_LOG(LogTemp, Warning, TEXT("Spawned %d benchmark bots"), Count);
+}
+
+void ABenchmarkBotController::RemoveBots(UWorld* World)
+{
+    if (World == nullptr)
+        return;
+    for (TActorIterator<ABenchmarkBotController> It(World); It; ++It)
+    {
+        if (APawn* Pawn = It->GetPawn())
+            Pawn->Destroy();
+        It->Destroy();
+    }
+}
@@ -3,16 +3,29 @@
 #include "Character/CombatComponent.h"
 
 #include "Camera/CameraComponent.h"
+#include "Character/LagCompensationComponent.h"
 #include "Character/OpenShooterCharacter.h"
+#include "Character/OpenShooterMovementComponent.h"
 #include "Character/OpenShooterPlayerController.h"
-#include "GameFramework/CharacterMovementComponent.h"
 #include "HUD/OpenShooterHUD.h"
 #include "Kismet/GameplayStatics.h"
+#include "Net/Core/PushModel/PushModel.h"
 #include "Net/UnrealNetwork.h"
+#include "OpenShooter.h"
 #include "Sound/SoundCue.h"
+#include "Subsystems/NetProfilerSubsystem.h"
 #include "Weapon/Weapon.h"
 
-#define TRACE_LENGTH 80000.f;
+DECLARE_CYCLE_STAT(TEXT("Crosshair Trace"), STAT_CrosshairTrace, STATGROUP_OpenShooter);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Crosshair Trace Policy"), STAT_CrosshairTracePolicy, STATGROUP_OpenShooter);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Crosshair Traces Issued"), STAT_CrosshairTracesIssued, STATGROUP_OpenShooter);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Crosshair Traces Reused"), STAT_CrosshairTracesReused, STATGROUP_OpenShooter);
+
+static TAutoConsoleVariable<int32> CVarCrosshairTracePolicy(TEXT("OpenShooter.CrosshairTrace.Policy"), 2,
+    TEXT("How the crosshair target is traced every frame.\n")
+    TEXT("0: synchronous trace\n")
+    TEXT("1: asynchronous trace, the result of the previous frame is used\n")
+    TEXT("2: asynchronous trace, skipped while the camera and the character do not move (default)"));
 
 UCombatComponent::UCombatComponent()
 {
@@ -26,10 +39,19 @@ void UCombatComponent::GetLifetimeReplicatedProps(TArray<FLifetimeProperty>& Out
 {
     Super::GetLifetimeReplicatedProps(OutLifetimeProps);
 
-    DOREPLIFETIME(UCombatComponent, EquippedWeapon);
-    DOREPLIFETIME(UCombatComponent, bAiming);
-    DOREPLIFETIME_CONDITION(UCombatComponent, CarriedAmmo, COND_OwnerOnly);    // this matter only for the client
-    DOREPLIFETIME(UCombatComponent, CombatState);
+    // Push model: these change rarely, so the net driver only compares them after we mark them dirty
+    FDoRepLifetimeParams Params;
+    Params.bIsPushBased = true;
+    DOREPLIFETIME_WITH_PARAMS_FAST(UCombatComponent, RepState, Params);
+
+    Params.Condition = COND_OwnerOnly;    // this matter only for the client
+    DOREPLIFETIME_WITH_PARAMS_FAST(UCombatComponent, CarriedAmmo, Params);
+}
+
+bool UCombatComponent::CallRemoteFunction(UFunction* Function, void* Parameters, FOutParmRec* OutParms, FFrame* Stack)
+{
+    FNetProfileRPCScope ProfileScope(this, Function);
+    return Super::CallRemoteFunction(Function, Parameters, OutParms, Stack);
 }
 
 void UCombatComponent::BeginPlay()
@@ -39,6 +61,8 @@ void UCombatComponent::BeginPlay()
     if (Character)
     {
         Character->GetCharacterMovement()->MaxWalkSpeed = BaseWalkSpeed;
+        if (UOpenShooterMovementComponent* Movement = Cast<UOpenShooterMovementComponent>(Character->GetCharacterMovement()))
+            Movement->MaxWalkSpeedAiming = AimWalkSpeed;
 
         // Set the current FOV and the default FOV
         if (Character->GetFollowCamera())
@@ -47,6 +71,15 @@ void UCombatComponent::BeginPlay()
             CurrentFOV = DefaultFOV;
         }
     }
+
+    PostActorTickHandle = FWorldDelegates::OnWorldPostActorTick.AddUObject(this, &UCombatComponent::OnWorldPostActorTick);
+}
+
+void UCombatComponent::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+    FWorldDelegates::OnWorldPostActorTick.Remove(PostActorTickHandle);
+
+    Super::EndPlay(EndPlayReason);
 }
 
 void UCombatComponent::TickComponent(float DeltaTime, ELevelTick TickType, FActorComponentTickFunction* ThisTickFunction)
@@ -58,9 +91,9 @@ void UCombatComponent::TickComponent(float DeltaTime, ELevelTick TickType, FActo
         SetHUDCrosshair(DeltaTime);
 
         // Obtain the hit target for the right hand rotation correction to aim at the crosshair
-        FHitResult HitResult;
-        TraceUnderCrosshair(HitResult);
-        HitTarget = HitResult.ImpactPoint;
+        TraceUnderCrosshair();
+
+        UpdateFireScheduler(DeltaTime);
 
         // Set the FOV based on the aiming state
         InterpFOV(DeltaTime);
@@ -84,17 +117,20 @@ void UCombatComponent::EquipWeapon(AWeapon* Weapon)
         EquippedWeapon->Drop();
 
     EquippedWeapon = Weapon;
+    UpdateRepState();
     EquippedWeapon->SetWeaponState(EWeaponState::EWS_Equipped);
     EquippedWeapon->AttachToComponent(
         Character->GetMesh(), FAttachmentTransformRules::SnapToTargetIncludingScale, "RightHandSocket");
     Character = Character ? Character : Cast<AOpenShooterCharacter>(GetOwner());
     EquippedWeapon->SetOwner(Character);
+    EquippedWeapon->AcknowledgeFireSequence(AckedFireSequence);
     EquippedWeapon->SetHUDWeaponInfo();
 
     // We set the carried ammo (controller)
     if (CarriedAmmoMap.Contains(EquippedWeapon->GetWeaponType()))
         CarriedAmmo =
             CarriedAmmoMap[EquippedWeapon->GetWeaponType()];    // this triggers OnRep_CarriedAmmo, and we need to update the HUD
+    MARK_PROPERTY_DIRTY_FROM_NAME(UCombatComponent, CarriedAmmo, this);
     Controller = Controller ? Controller : Cast<AOpenShooterPlayerController>(Character->GetController());
     if (Controller)
     {
@@ -106,7 +142,7 @@ void UCombatComponent::EquipWeapon(AWeapon* Weapon)
     Character->GetCharacterMovement()->bOrientRotationToMovement = false;
     Character->bUseControllerRotationYaw = true;
 
-    // only for server. Play on the client in OnRep_EquippedWeapon
+    // only for server. Play on the client in HandleEquippedWeapon
     if (EquippedWeapon->EquipSound)
         UGameplayStatics::PlaySoundAtLocation(this, EquippedWeapon->EquipSound, Character->GetActorLocation());
 
@@ -117,7 +153,48 @@ void UCombatComponent::EquipWeapon(AWeapon* Weapon)
     UE_LOG(LogTemp, Warning, TEXT("Weapon Equipped!"));
 }
 
-void UCombatComponent::OnRep_EquippedWeapon() const
+void UCombatComponent::UpdateRepState()
+{
+    if (!GetOwner()->HasAuthority())
+        return;
+    RepState.EquippedWeapon = EquippedWeapon;
+    RepState.WeaponType = EquippedWeapon ? EquippedWeapon->GetWeaponType() : EWeaponType::EWT_MAX;
+    RepState.CombatState = CombatState;
+    RepState.bAiming = bAiming;
+    MARK_PROPERTY_DIRTY_FROM_NAME(UCombatComponent, RepState, this);
+}
+
+void UCombatComponent::OnRep_RepState()
+{
+    // The weapon first: the montages of the combat state and of the shots need it
+    if (RepState.EquippedWeapon != EquippedWeapon)
+    {
+        EquippedWeapon = RepState.EquippedWeapon;
+        HandleEquippedWeapon();
+    }
+
+    // The owner predicts its aiming, the server only echoes it back
+    const bool bLocallyControlled = Character && Character->IsLocallyControlled();
+    if (!bLocallyControlled)
+        bAiming = RepState.bAiming;
+
+    if (RepState.CombatState != CombatState)
+    {
+        CombatState = RepState.CombatState;
+        HandleCombatState();
+    }
+
+    // The difference is read as a signed number of shots, so a multicast arriving before the state does not count as missing
+    constexpr int32 Half = (FCombatRepState::FireCountMask + 1) / 2;
+    const int32 MissingShots = ((RepState.FireCount - PlayedFireCount + Half) & FCombatRepState::FireCountMask) - Half;
+    if (!bLocallyControlled && MissingShots > 0 && Character && EquippedWeapon)
+    {
+        Character->PlayFireMontage(bAiming);
+        PlayedFireCount = RepState.FireCount;
+    }
+}
+
+void UCombatComponent::HandleEquippedWeapon() const
 {
     if (EquippedWeapon && Character)
     {
@@ -137,7 +214,7 @@ void UCombatComponent::OnRep_EquippedWeapon() const
     }
 }
 
-void UCombatComponent::OnRep_CombatState()
+void UCombatComponent::HandleCombatState()
 {    // all of the following is run on the client
     switch (CombatState)
     {
@@ -159,74 +236,178 @@ void UCombatComponent::FireButtonPressed(const bool bButtonPressed)
         Fire();
 }
 
-void UCombatComponent::Fire()
+void UCombatComponent::Fire(const float TimeOffset)
 {
     if (!CanFire())
         return;
-    bCanFire = false;    // we set this to false to prevent the player from firing too quickly
-    // We set it to true in the FireTimerFinished function
+    // Prevents the player from firing too quickly, the cooldown runs in UpdateFireScheduler
+    FireCooldown += FMath::Max(EquippedWeapon->GetFireDelay(), MinFireDelay);
 
     // If we replace ServerFire with MulticastFire directly here, it will work only server and not on clients.
     // The reason is that clients do not have authority to call multicast functions directly; only the server can do that.
-    ServerFire(HitTarget);
+    // We timestamp the shot with the server clock, so the server can evaluate the hit against what we were seeing. The other
+    // characters reached us a single trip ago, so that is the server time of the world we were aiming at
+    Controller = Controller ? Controller : Cast<AOpenShooterPlayerController>(Character->Controller);
+    const float ViewTime =
+        Controller ? Controller->GetServerTime() - Controller->GetSingleTripTime() : GetWorld()->GetTimeSeconds();
+    const float FireTime = ViewTime + TimeOffset;
+
+    // We play the shot right away instead of waiting for the server, and queue it for the end of the frame
+    // The target is rounded the way it will be sent, so the scatter we play is the same everyone else derives from it
+    const FVector_NetQuantize Target(
+        FMath::RoundToDouble(HitTarget.X), FMath::RoundToDouble(HitTarget.Y), FMath::RoundToDouble(HitTarget.Z));
+    // A listen server only relays the shots it played, like the shots of its clients, so the fire count of the proxies stays
+    // in step with RepState.FireCount
+    const uint16 FireSequence = NextFireSequence;
+    if (!PlayFire(Target, FireTime, FireSequence) && GetOwner()->HasAuthority())
+        return;
+    ++NextFireSequence;
+    PendingShots.Add(Target, FireTime, FireSequence);
+    if (PendingShots.IsFull())
+        FlushPendingShots();
 
     // if we are shooting, we should increase the spread of the crosshair
-    if (EquippedWeapon)
-    {
-        CrosshairShootingFactor = FMath::Clamp(CrosshairShootingFactor + 0.75f, 0.f, 10.f);
+    CrosshairShootingFactor = FMath::Clamp(CrosshairShootingFactor + 0.75f, 0.f, 10.f);
 
-        // We start the timer to fire the next shot if the weapon is automatic
-        if (EquippedWeapon->IsAutomatic())
-            StartFireTimer();
-    }
+    // Reloading right away would reach the server before the batch with this shot, and the shot would be refused
+    bReloadWhenReady = EquippedWeapon->IsEmpty();
 }
 
 bool UCombatComponent::CanFire() const
 {
     if (EquippedWeapon == nullptr || Character == nullptr)
         return false;
-    return !EquippedWeapon->IsEmpty() && bCanFire && CombatState == ECombatState::ECS_Unoccupied;
+    return !EquippedWeapon->IsEmpty() && FireCooldown <= 0.f && CombatState == ECombatState::ECS_Unoccupied;
 }
 
-void UCombatComponent::StartFireTimer()
+void UCombatComponent::UpdateFireScheduler(const float DeltaTime)
 {
-    if (EquippedWeapon == nullptr || Character == nullptr)
-        return;
+    FireCooldown -= DeltaTime;
+
+    // Fire every shot that became due during this frame. A negative cooldown is how long ago the shot was due, so each shot
+    // gets the timestamp it would have had with an infinite frame rate
+    while (bFireButtonPressed && EquippedWeapon && EquippedWeapon->IsAutomatic() && CanFire())
+        Fire(FireCooldown);
+
+    if (FireCooldown <= 0.f)
+    {
+        // Not firing: don't bank time, or the next trigger pull would fire a burst
+        FireCooldown = 0.f;
 
-    Character->GetWorldTimerManager().SetTimer(
-        FireTimer, this, &UCombatComponent::FireTimerFinished, EquippedWeapon->GetFireDelay(), false);
+        // if the magazine is empty, we automatically reload
+        if (bReloadWhenReady)
+        {
+            bReloadWhenReady = false;
+            if (EquippedWeapon && EquippedWeapon->IsEmpty())
+                Reload();
+        }
+    }
 }
-void UCombatComponent::FireTimerFinished()
+
+void UCombatComponent::OnWorldPostActorTick(UWorld* World, ELevelTick TickType, float DeltaSeconds)
 {
-    bCanFire = true;
+    if (World == GetWorld() && PendingShots.Num() > 0)
+        FlushPendingShots();
+}
 
-    // needs to check if we still have the fire button pressed
-    if (bFireButtonPressed && EquippedWeapon->IsAutomatic())
-        Fire();
+void UCombatComponent::FlushPendingShots()
+{
+    PendingShots.RecordSent();
 
-    // if the magazine is empty, we automatically reload
-    if (EquippedWeapon->IsEmpty())
-        Reload();
+    // On a listen server the shots have already been played with authority, the others only need the cosmetics
+    if (GetOwner()->HasAuthority())
+        MulticastFireBatch(PendingShots);
+    else
+        ServerFireBatch(PendingShots);
+    PendingShots.Reset();
 }
 
-void UCombatComponent::ServerFire_Implementation(const FVector_NetQuantize& TraceHitTarget)
+void UCombatComponent::ServerFireBatch_Implementation(const FFireBatch& Batch)
 {
-    MulticastFire(TraceHitTarget);
+    if (Batch.Num() == 0)
+        return;
+
+    // The shots leave from the muzzle socket: on a dedicated server the mesh of the shooter is not animated by itself
+    if (ULagCompensationComponent* LagCompensation = Character ? Character->GetLagCompensation() : nullptr)
+        LagCompensation->EvaluatePose();
+
+    // Only the shots we played are relayed. The sequences of a batch follow each other, so a rejected shot in the middle
+    // starts another batch
+    TArray<FFireBatch, TInlineAllocator<2>> Relayed;
+    float PreviousFireTime = TNumericLimits<float>::Lowest();
+    for (int32 i = 0; i < Batch.Num(); ++i)
+    {
+        const float FireTime = Batch.FireTimes[i];
+        const uint16 FireSequence = Batch.GetSequence(i);
+        const bool bValidTime = IsValidFireTime(FireTime, PreviousFireTime);
+        PreviousFireTime = FMath::Max(PreviousFireTime, FireTime);
+        if (!bValidTime || !PlayFire(Batch.Targets[i], FireTime, FireSequence))
+            continue;
+
+        LastAcceptedFireTime = FireTime;
+        if (Relayed.Num() == 0 || Relayed.Last().GetSequence(Relayed.Last().Num()) != FireSequence)
+            Relayed.AddDefaulted();
+        Relayed.Last().Add(Batch.Targets[i], FireTime, FireSequence);
+    }
+
+    // Even the shots we rejected are acknowledged, so the client stops predicting them and gets its rounds back
+    AckedFireSequence = Batch.GetSequence(Batch.Num() - 1);
+    if (EquippedWeapon)
+        EquippedWeapon->AcknowledgeFireSequence(AckedFireSequence);
+    for (const FFireBatch& Shots : Relayed)
+    {
+        Shots.RecordSent();
+        MulticastFireBatch(Shots);
+    }
 }
 
-void UCombatComponent::MulticastFire_Implementation(const FVector_NetQuantize& TraceHitTarget)
+bool UCombatComponent::IsValidFireTime(const float FireTime, const float PreviousFireTime) const
 {
-    if (EquippedWeapon == nullptr)
+    const float Now = GetWorld()->GetTimeSeconds();
+    if (FireTime > Now || FireTime < Now - MaxFireTimeAge || FireTime < PreviousFireTime)
+        return false;
+
+    const float FireDelay = FMath::Max(EquippedWeapon ? EquippedWeapon->GetFireDelay() : 0.f, MinFireDelay);
+    return FireTime >= LastAcceptedFireTime + FireDelay - FireTimeTolerance;
+}
+
+void UCombatComponent::MulticastFireBatch_Implementation(const FFireBatch& Batch)
+{
+    // The server and the shooter already played these shots
+    if (GetOwner()->HasAuthority() || (Character && Character->IsLocallyControlled()))
         return;
-    if (Character && CombatState == ECombatState::ECS_Unoccupied)
+    for (int32 i = 0; i < Batch.Num(); ++i)
+        PlayFire(Batch.Targets[i], Batch.FireTimes[i], Batch.GetSequence(i));
+    PlayedFireCount = static_cast<uint8>((PlayedFireCount + Batch.Num()) & FCombatRepState::FireCountMask);
+}
+
+bool UCombatComponent::PlayFire(const FVector_NetQuantize& TraceHitTarget, const float FireTime, const uint16 FireSequence)
+{
+    if (EquippedWeapon == nullptr)
+        return false;
+    // The server has the real ammo count, a client may have predicted a round that is not there
+    if (GetOwner()->HasAuthority() && EquippedWeapon->IsEmpty())
+        return false;
+    if (Character == nullptr || CombatState != ECombatState::ECS_Unoccupied)
+        return false;
+
+    Character->PlayFireMontage(bAiming);
+    EquippedWeapon->Fire(TraceHitTarget, FireTime, FireSequence);
+    LastFireTime = GetWorld()->GetTimeSeconds();
+    if (GetOwner()->HasAuthority())
     {
-        Character->PlayFireMontage(bAiming);
-        EquippedWeapon->Fire(TraceHitTarget);
+        RepState.FireCount = static_cast<uint8>((RepState.FireCount + 1) & FCombatRepState::FireCountMask);
+        MARK_PROPERTY_DIRTY_FROM_NAME(UCombatComponent, RepState, this);
     }
+    return true;
 }
 
-void UCombatComponent::TraceUnderCrosshair(FHitResult& HitResult)
+void UCombatComponent::TraceUnderCrosshair()
 {
+    SCOPE_CYCLE_COUNTER(STAT_CrosshairTrace);
+    const int32 Policy = CVarCrosshairTracePolicy.GetValueOnGameThread();
+    SET_DWORD_STAT(STAT_CrosshairTracePolicy, Policy);
+
     // We trace from the center of the screen (crosshair)
     FVector2D ViewportSize;
     if (GEngine && GEngine->GameViewport)
@@ -242,26 +423,69 @@ void UCombatComponent::TraceUnderCrosshair(FHitResult& HitResult)
         UGameplayStatics::GetPlayerController(this, 0), CrosshairLocation, CrosshairWorldPosition, CrosshairWorldDirection);
     if (bScreenToWorld)
     {
+        const FVector CharacterLocation = Character ? Character->GetActorLocation() : FVector::ZeroVector;
+        const float Now = GetWorld()->GetTimeSeconds();
+
+        // Nothing moved since the last trace: its result is still good
+        if (Policy == 2 && LastTraceTime >= 0.f && Now - LastTraceTime < CrosshairMaxReuseTime &&
+            FVector::DistSquared(CrosshairWorldPosition, LastTraceViewLocation) < FMath::Square(CrosshairReuseDistance) &&
+            FVector::DistSquared(CharacterLocation, LastTraceCharacterLocation) < FMath::Square(CrosshairReuseDistance) &&
+            (CrosshairWorldDirection | LastTraceViewDirection) > FMath::Cos(FMath::DegreesToRadians(CrosshairReuseAngle)))
+        {
+            INC_DWORD_STAT(STAT_CrosshairTracesReused);
+            return;
+        }
+        LastTraceViewLocation = CrosshairWorldPosition;
+        LastTraceViewDirection = CrosshairWorldDirection;
+        LastTraceCharacterLocation = CharacterLocation;
+        LastTraceTime = Now;
+
         FVector Start = CrosshairWorldPosition;
 
         if (Character)
         {    // we push forward the start location to avoid hitting the character and characters behind the character
-            const float DistanceToCharacter = FVector::Dist(Character->GetActorLocation(), Start);
+            const float DistanceToCharacter = FVector::Dist(CharacterLocation, Start);
             Start += CrosshairWorldDirection * (DistanceToCharacter + 100.f);
         }
 
         const FVector End = CrosshairWorldPosition + CrosshairWorldDirection * TRACE_LENGTH;
 
-        FCollisionQueryParams QueryParams;
+        FCollisionQueryParams QueryParams(SCENE_QUERY_STAT(CrosshairTrace), false);
         QueryParams.AddIgnoredActor(Character);
         QueryParams.AddIgnoredActor(EquippedWeapon);
-        GetWorld()->LineTraceSingleByChannel(HitResult, Start, End, ECollisionChannel::ECC_Visibility, QueryParams);
+        INC_DWORD_STAT(STAT_CrosshairTracesIssued);
+
+        if (Policy == 0)
+        {
+            FHitResult HitResult;
+            GetWorld()->LineTraceSingleByChannel(HitResult, Start, End, ECollisionChannel::ECC_Visibility, QueryParams);
+            SetCrosshairTarget(HitResult, End);
+            return;
+        }
 
-        // We set this, so we can change the spread and the color of the crosshair
-        OnTarget = HitResult.GetActor() && HitResult.GetActor()->Implements<UInteractWithCrosshairInterface>();
+        // The result comes back at the start of the next frame, in OnCrosshairTraceDone
+        if (!CrosshairTraceDelegate.IsBound())
+            CrosshairTraceDelegate.BindUObject(this, &UCombatComponent::OnCrosshairTraceDone);
+        GetWorld()->AsyncLineTraceByChannel(EAsyncTraceType::Single, Start, End, ECollisionChannel::ECC_Visibility, QueryParams,
+            FCollisionResponseParams::DefaultResponseParam, &CrosshairTraceDelegate);
     }
 }
 
+void UCombatComponent::OnCrosshairTraceDone(const FTraceHandle& TraceHandle, FTraceDatum& TraceDatum)
+{
+    const FHitResult HitResult = TraceDatum.OutHits.Num() > 0 ? TraceDatum.OutHits[0] : FHitResult();
+    SetCrosshairTarget(HitResult, TraceDatum.End);
+}
+
+void UCombatComponent::SetCrosshairTarget(const FHitResult& HitResult, const FVector& TraceEnd)
+{
+    // Aim at the end of the trace when we are pointing at the sky
+    HitTarget = HitResult.bBlockingHit ? FVector(HitResult.ImpactPoint) : TraceEnd;
+
+    // We set this, so we can change the spread and the color of the crosshair
+    OnTarget = HitResult.GetActor() && HitResult.GetActor()->Implements<UInteractWithCrosshairInterface>();
+}
+
 void UCombatComponent::SetHUDCrosshair(float DeltaSeconds)
 {
     if (Character == nullptr || Character->Controller == nullptr)
@@ -290,7 +514,7 @@ void UCombatComponent::SetHUDCrosshair(float DeltaSeconds)
                 HUDPackage.CrosshairsTop = nullptr;
             }
             // Calculate the spread of the crosshair
-            FVector2D WalkSpeedRange(0.f, Character->GetCharacterMovement()->MaxWalkSpeed);
+            FVector2D WalkSpeedRange(0.f, Character->GetCharacterMovement()->GetMaxSpeed());
             FVector2D VelocityMultiplierRange(0.f, 1.f);
             FVector Velocity = Character->GetVelocity();
             Velocity.Z = 0.f;
@@ -374,6 +598,7 @@ void UCombatComponent::UpdateAmmoValues()
         return;
 
     CarriedAmmo -= AmmoToReload;              // Subtract from your carried ammo
+    MARK_PROPERTY_DIRTY_FROM_NAME(UCombatComponent, CarriedAmmo, this);
     EquippedWeapon->AddAmmo(AmmoToReload);    // Add to the weapon’s magazine
 
     Controller = Controller ? Controller : Cast<AOpenShooterPlayerController>(Character->GetController());
@@ -385,6 +610,7 @@ void UCombatComponent::UpdateAmmoValues()
 void UCombatComponent::ServerReload_Implementation()
 {
     CombatState = ECombatState::ECS_Reloading;
+    UpdateRepState();
     HandleReload();
 }
 
@@ -398,6 +624,7 @@ void UCombatComponent::FinishReloading()
     if (Character && Character->HasAuthority())
     {
         CombatState = ECombatState::ECS_Unoccupied;
+        UpdateRepState();
         UpdateAmmoValues();
     }
     if (bFireButtonPressed)
@@ -434,29 +661,15 @@ void UCombatComponent::SetAiming(const bool bIsAiming)
     // so that the animation can be updated immediately.
     // The server will eventually replicate this to all the clients
     bAiming = bIsAiming;
-
-    // Then we call this function to tell the server to set the aiming state there
-    // if we would use only the one below, the client would have to wait for the server to replicate the variable
-    // to know that the character is aiming, which would cause a delay in the animation
-    ServerSetAiming(bIsAiming);
+    UpdateRepState();
 
     UE_LOG(LogTemp, Warning, TEXT("Setting Aiming %d"), bIsAiming);
 
-    // Set the walk speed based on the aiming state
-    if (Character)
-    {
-        Character->GetCharacterMovement()->MaxWalkSpeed = bIsAiming ? AimWalkSpeed : BaseWalkSpeed;
-    }
-}
-
-void UCombatComponent::ServerSetAiming_Implementation(const bool bIsAiming)
-{
-    // This is the function that the client calls to tell the server to set the aiming state
-    bAiming = bIsAiming;
-
-    // Set the walk speed based on the aiming state
-    if (Character)
-        Character->GetCharacterMovement()->MaxWalkSpeed = bIsAiming ? AimWalkSpeed : BaseWalkSpeed;
+    // The movement component sends the aiming to the server with the next move and applies the aim walk speed on both sides
+    // at the same move. On the server, this is called back by the movement component when the move arrives
+    if (UOpenShooterMovementComponent* Movement =
+            Character ? Cast<UOpenShooterMovementComponent>(Character->GetCharacterMovement()) : nullptr)
+        Movement->SetWantsToAim(bIsAiming);
 }
 
 void UCombatComponent::OnRep_CarriedAmmo()
@@ -0,0 +1,40 @@
+// Copyright (c) 2024 Rasna Studios. All rights reserved.
+
+#include "Character/CombatRepState.h"
+
+#include "Subsystems/NetProfilerSubsystem.h"
+#include "Weapon/Weapon.h"
+
+bool FCombatRepState::NetSerialize(FArchive& Ar, UPackageMap* Map, bool& bOutSuccess)
+{
+    FNetProfilePropertyScope ProfileScope(TEXT("CombatRepState"), *this, Ar, Map);
+    bOutSuccess = true;
+
+    // [0] aiming, [1-2] combat state, [3-5] weapon type, [6-11] fire count
+    uint32 Packed = 0;
+    if (Ar.IsSaving())
+    {
+        Packed = (bAiming ? 1u : 0u) | static_cast<uint32>(CombatState) << 1 | static_cast<uint32>(WeaponType) << 3 |
+                 (FireCount & FireCountMask) << 6;
+    }
+    Ar.SerializeBits(&Packed, 6 + FireCountBits);
+    if (Ar.IsLoading())
+    {
+        bAiming = (Packed & 1) != 0;
+        CombatState = static_cast<ECombatState>((Packed >> 1) & 3);
+        WeaponType = static_cast<EWeaponType>((Packed >> 3) & 7);
+        FireCount = static_cast<uint8>((Packed >> 6) & FireCountMask);
+        if (CombatState >= ECombatState::ECS_MAX || WeaponType > EWeaponType::EWT_MAX)
+        {
+            bOutSuccess = false;
+            return false;
+        }
+    }
+
+    // An unmapped weapon is resolved later by the replication system, which calls the OnRep again
+    UObject* Weapon = EquippedWeapon;
+    Map->SerializeObject(Ar, AWeapon::StaticClass(), Weapon);
+    if (Ar.IsLoading())
+        EquippedWeapon = Cast<AWeapon>(Weapon);
+    return true;
+}
@@ -0,0 +1,34 @@
+// Copyright (c) 2024 Rasna Studios. All rights reserved.
+
+#include "Character/HealthRepState.h"
+
+#include "Subsystems/NetProfilerSubsystem.h"
+
+bool FHealthRepState::NetSerialize(FArchive& Ar, UPackageMap* Map, bool& bOutSuccess)
+{
+    FNetProfilePropertyScope ProfileScope(TEXT("HealthState"), *this, Ar, Map);
+    bOutSuccess = true;
+
+    uint8 bWide = Health > MAX_uint8;
+    Ar.SerializeBits(&bWide, 1);
+    if (bWide)
+    {
+        Ar << Health;
+    }
+    else
+    {
+        uint8 NarrowHealth = static_cast<uint8>(Health);
+        Ar << NarrowHealth;
+        Health = NarrowHealth;
+    }
+
+    // [0-3] hit count, [4-5] direction
+    uint8 Packed = (HitCount & HitCountMask) | static_cast<uint8>(LastHitDirection) << HitCountBits;
+    Ar.SerializeBits(&Packed, HitCountBits + 2);
+    if (Ar.IsLoading())
+    {
+        HitCount = Packed & HitCountMask;
+        LastHitDirection = static_cast<EHitDirection>(Packed >> HitCountBits & 3);
+    }
+    return true;
+}
@@ -0,0 +1,327 @@
+// Copyright (c) 2024 Rasna Studios. All rights reserved.
+
+#include "Character/LagCompensationComponent.h"
+
+#include "Animation/AnimInstance.h"
+#include "Character/OpenShooterCharacter.h"
+#include "GameFramework/CharacterMovementComponent.h"
+#include "OpenShooter.h"
+#include "Subsystems/LagCompensationSubsystem.h"
+
+DECLARE_DWORD_COUNTER_STAT(TEXT("Sampled Hitbox Poses"), STAT_SampledHitboxPoses, STATGROUP_OpenShooter);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Procedural Hitbox Poses"), STAT_ProceduralHitboxPoses, STATGROUP_OpenShooter);
+
+static TAutoConsoleVariable<int32> CVarServerProceduralPose(TEXT("OpenShooter.Server.ProceduralPose"), 1,
+    TEXT("On a dedicated server, do not animate the characters and record their hitboxes from a procedural pose. Read at spawn"),
+    ECVF_Default);
+
+ULagCompensationComponent::ULagCompensationComponent()
+{
+    PrimaryComponentTick.bCanEverTick = true;
+    // We want to record the pose after the animation has been evaluated and the character has moved
+    PrimaryComponentTick.TickGroup = TG_PostPhysics;
+
+    // Default hitboxes for the Epic character skeleton
+    Hitboxes = {
+        {FName("head"), NAME_None, 16.f, true},
+        {FName("pelvis"), FName("neck_01"), 22.f},
+        {FName("upperarm_l"), FName("lowerarm_l"), 8.f, true},
+        {FName("lowerarm_l"), FName("hand_l"), 7.f, true},
+        {FName("upperarm_r"), FName("lowerarm_r"), 8.f, true},
+        {FName("lowerarm_r"), FName("hand_r"), 7.f, true},
+        {FName("thigh_l"), FName("calf_l"), 11.f},
+        {FName("calf_l"), FName("foot_l"), 9.f},
+        {FName("thigh_r"), FName("calf_r"), 11.f},
+        {FName("calf_r"), FName("foot_r"), 9.f},
+    };
+}
+
+void ULagCompensationComponent::BeginPlay()
+{
+    Super::BeginPlay();
+
+    // Only the server rewinds, clients never need the history
+    if (!GetOwner() || !GetOwner()->HasAuthority())
+    {
+        SetComponentTickEnabled(false);
+        return;
+    }
+
+    // Allocate the whole history once. Nothing is allocated while recording
+    MaxFrames = FMath::Max(MaxFrames, 2);
+    NumHitboxes = Hitboxes.Num();
+    FrameTimes.SetNumZeroed(MaxFrames);
+    FrameCenters.SetNumZeroed(MaxFrames);
+    SegmentStarts.SetNumZeroed(MaxFrames * NumHitboxes);
+    SegmentEnds.SetNumZeroed(MaxFrames * NumHitboxes);
+    Radii.SetNumUninitialized(NumHitboxes);
+    for (int32 i = 0; i < NumHitboxes; ++i)
+        Radii[i] = Hitboxes[i].Radius;
+
+    MinRecordInterval = MaxRewindTime / (MaxFrames - 1);
+
+    // Montages still tick so their notifies (e.g. the end of a reload) keep firing, but the pose is no longer evaluated
+    bProceduralPose = GetNetMode() == NM_DedicatedServer && CVarServerProceduralPose.GetValueOnGameThread() != 0;
+    if (bProceduralPose && Character && Character->GetMesh())
+        Character->GetMesh()->VisibilityBasedAnimTickOption = EVisibilityBasedAnimTickOption::OnlyTickMontagesWhenNotRendered;
+
+    // Spread the periodic samples of the characters over the interval
+    NextPoseSampleTime = GetWorld()->GetTimeSeconds() + FMath::FRandRange(0.f, PoseSampleInterval);
+
+    if (ULagCompensationSubsystem* Subsystem = GetWorld()->GetSubsystem<ULagCompensationSubsystem>())
+        Subsystem->Register(this);
+}
+
+void ULagCompensationComponent::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+    if (UWorld* World = GetWorld())
+        if (ULagCompensationSubsystem* Subsystem = World->GetSubsystem<ULagCompensationSubsystem>())
+            Subsystem->Unregister(this);
+
+    Super::EndPlay(EndPlayReason);
+}
+
+void ULagCompensationComponent::TickComponent(float DeltaTime, ELevelTick TickType, FActorComponentTickFunction* ThisTickFunction)
+{
+    Super::TickComponent(DeltaTime, TickType, ThisTickFunction);
+
+    const float Now = GetWorld()->GetTimeSeconds();
+    if (NumRecorded == 0 || Now - FrameTimes[Head] >= MinRecordInterval)
+        RecordFrame(Now);
+}
+
+void ULagCompensationComponent::RecordFrame(const float Time)
+{
+    if (Character == nullptr || Character->GetMesh() == nullptr)
+        return;
+
+    const USkeletalMeshComponent* Mesh = Character->GetMesh();
+
+    Head = (Head + 1) % MaxFrames;
+    NumRecorded = FMath::Min(NumRecorded + 1, MaxFrames);
+
+    FrameTimes[Head] = Time;
+    FrameCenters[Head] = Character->GetActorLocation();
+
+    const int32 Base = Head * NumHitboxes;
+    if (bProceduralPose)
+    {
+        // The real pose the first time we see each stance, every PoseSampleInterval, and while a shot asks for it
+        FPoseTemplate& Template = Character->bIsCrouched ? CrouchedPose : StandingPose;
+        const bool bPeriodicSample = Time >= NextPoseSampleTime;
+        if (bPeriodicSample)
+            NextPoseSampleTime = Time + PoseSampleInterval;
+        if (!Template.bValid || Time < PoseSampleEndTime || bPeriodicSample)
+            RecordSampledFrame(Base, Template);
+        else
+            RecordProceduralFrame(Base, Template);
+        return;
+    }
+
+    for (int32 i = 0; i < NumHitboxes; ++i)
+    {
+        const FLagCompensationHitbox& Hitbox = Hitboxes[i];
+        const FVector Start = Mesh->GetSocketLocation(Hitbox.StartBone);
+        SegmentStarts[Base + i] = Start;
+        SegmentEnds[Base + i] = Hitbox.EndBone.IsNone() ? Start : Mesh->GetSocketLocation(Hitbox.EndBone);
+    }
+}
+
+void ULagCompensationComponent::RequestPoseSample(const float Duration)
+{
+    if (bProceduralPose)
+        PoseSampleEndTime = FMath::Max(PoseSampleEndTime, GetWorld()->GetTimeSeconds() + Duration);
+}
+
+void ULagCompensationComponent::EvaluatePose()
+{
+    if (!bProceduralPose || Character == nullptr || Character->GetMesh() == nullptr || PoseEvaluationFrame == GFrameCounter)
+        return;
+
+    // Evaluate the animation right now, on the game thread. The mesh does not do it by itself on a dedicated server
+    USkeletalMeshComponent* Mesh = Character->GetMesh();
+    Mesh->TickAnimation(0.f, false);
+    Mesh->RefreshBoneTransforms();
+    PoseEvaluationFrame = GFrameCounter;
+}
+
+FTransform ULagCompensationComponent::GetReferenceTransform() const
+{
+    return FTransform(FRotator(0.f, Character->GetActorRotation().Yaw, 0.f), Character->GetActorLocation());
+}
+
+void ULagCompensationComponent::RecordSampledFrame(const int32 Base, FPoseTemplate& Template)
+{
+    INC_DWORD_STAT(STAT_SampledHitboxPoses);
+
+    // Evaluated again even if the shots of this frame already did it (see EvaluatePose): the character has moved since
+    PoseEvaluationFrame = 0;
+    EvaluatePose();
+    const USkeletalMeshComponent* Mesh = Character->GetMesh();
+
+    for (int32 i = 0; i < NumHitboxes; ++i)
+    {
+        const FLagCompensationHitbox& Hitbox = Hitboxes[i];
+        const FVector Start = Mesh->GetSocketLocation(Hitbox.StartBone);
+        SegmentStarts[Base + i] = Start;
+        SegmentEnds[Base + i] = Hitbox.EndBone.IsNone() ? Start : Mesh->GetSocketLocation(Hitbox.EndBone);
+    }
+
+    // A reload, a hit react or a jump would be replayed on every procedural frame until the next neutral sample
+    if (Template.bValid && !IsNeutralPose())
+        return;
+
+    const FTransform Reference = GetReferenceTransform();
+    Template.Starts.SetNumUninitialized(NumHitboxes);
+    Template.Ends.SetNumUninitialized(NumHitboxes);
+    for (int32 i = 0; i < NumHitboxes; ++i)
+    {
+        Template.Starts[i] = Reference.InverseTransformPosition(SegmentStarts[Base + i]);
+        Template.Ends[i] = Reference.InverseTransformPosition(SegmentEnds[Base + i]);
+    }
+    Template.AimPivot = Reference.InverseTransformPosition(Mesh->GetSocketLocation(AimPivotBone));
+    Template.AimPitch = Character->GetAimOffsetPitch();
+    Template.bValid = true;
+}
+
+bool ULagCompensationComponent::IsNeutralPose() const
+{
+    const UAnimInstance* AnimInstance = Character->GetMesh()->GetAnimInstance();
+    if (AnimInstance && AnimInstance->IsAnyMontagePlaying())
+        return false;
+    if (Character->GetCharacterMovement()->IsFalling())
+        return false;
+    return Character->GetVelocity().SizeSquared2D() <= FMath::Square(NeutralPoseMaxSpeed);
+}
+
+void ULagCompensationComponent::RecordProceduralFrame(const int32 Base, const FPoseTemplate& Template)
+{
+    INC_DWORD_STAT(STAT_ProceduralHitboxPoses);
+
+    // The template at the current location and yaw (the crouch is in the template), with the upper body pitched by how much the
+    // aim moved since the template was sampled
+    const FTransform Reference = GetReferenceTransform();
+    const FQuat AimRotation(FRotator(Character->GetAimOffsetPitch() - Template.AimPitch, 0.f, 0.f));
+    for (int32 i = 0; i < NumHitboxes; ++i)
+    {
+        FVector Start = Template.Starts[i];
+        FVector End = Template.Ends[i];
+        if (Hitboxes[i].bFollowsAimPitch)
+        {
+            Start = Template.AimPivot + AimRotation.RotateVector(Start - Template.AimPivot);
+            End = Template.AimPivot + AimRotation.RotateVector(End - Template.AimPivot);
+        }
+        SegmentStarts[Base + i] = Reference.TransformPosition(Start);
+        SegmentEnds[Base + i] = Reference.TransformPosition(End);
+    }
+}
+
+float ULagCompensationComponent::GetOldestRecordedTime() const
+{
+    if (NumRecorded == 0)
+        return 0.f;
+    const int32 Oldest = (Head - NumRecorded + 1 + MaxFrames) % MaxFrames;
+    return FrameTimes[Oldest];
+}
+
+bool ULagCompensationComponent::FindFrames(const float Time, int32& OutOlder, int32& OutNewer, float& OutAlpha) const
+{
+    if (NumRecorded == 0)
+        return false;
+
+    // Newer than the latest frame: use the latest pose
+    OutNewer = Head;
+    OutOlder = Head;
+    OutAlpha = 0.f;
+    if (Time >= FrameTimes[Head])
+        return true;
+
+    // Walk back in time until we find the frame just before Time. If we run out of history we clamp to the oldest frame
+    for (int32 Step = 1; Step < NumRecorded; ++Step)
+    {
+        OutOlder = (Head - Step + MaxFrames) % MaxFrames;
+        if (FrameTimes[OutOlder] <= Time)
+        {
+            const float Span = FrameTimes[OutNewer] - FrameTimes[OutOlder];
+            OutAlpha = Span > KINDA_SMALL_NUMBER ? (Time - FrameTimes[OutOlder]) / Span : 0.f;
+            return true;
+        }
+        OutNewer = OutOlder;
+    }
+    OutAlpha = 0.f;
+    return true;
+}
+
+bool ULagCompensationComponent::IntersectSegmentAtTime(
+    const FVector& Start, const FVector& End, const float Time, FRewindHit& OutHit) const
+{
+    return IntersectSegmentsAtTime(Start, MakeArrayView(&End, 1), Time, MakeArrayView(&OutHit, 1)) > 0;
+}
+
+int32 ULagCompensationComponent::IntersectSegmentsAtTime(
+    const FVector& Start, const TArrayView<const FVector> Ends, const float Time, TArrayView<FRewindHit> OutHits) const
+{
+    check(Ends.Num() == OutHits.Num());
+
+    int32 Older, Newer;
+    float Alpha;
+    if (!FindFrames(Time, Older, Newer, Alpha))
+        return 0;
+
+    // Broad phase: skip the segments that do not even get close to the character
+    const FVector Center = FMath::Lerp(FrameCenters[Older], FrameCenters[Newer], Alpha);
+    const float BoundsRadiusSquared = FMath::Square(BoundsRadius);
+    bool bAnyCandidate = false;
+    for (int32 s = 0; s < Ends.Num(); ++s)
+    {
+        OutHits[s].HitboxIndex = INDEX_NONE;
+        OutHits[s].Distance = TNumericLimits<float>::Max();
+        bAnyCandidate |= FMath::PointDistToSegmentSquared(Center, Start, Ends[s]) <= BoundsRadiusSquared;
+    }
+    if (!bAnyCandidate)
+        return 0;
+
+    // Interpolate the pose once for the whole batch
+    TArray<FVector, TInlineAllocator<16>> A, B;
+    A.SetNumUninitialized(NumHitboxes);
+    B.SetNumUninitialized(NumHitboxes);
+    const int32 OlderBase = Older * NumHitboxes;
+    const int32 NewerBase = Newer * NumHitboxes;
+    for (int32 i = 0; i < NumHitboxes; ++i)
+    {
+        A[i] = FMath::Lerp(SegmentStarts[OlderBase + i], SegmentStarts[NewerBase + i], Alpha);
+        B[i] = FMath::Lerp(SegmentEnds[OlderBase + i], SegmentEnds[NewerBase + i], Alpha);
+    }
+
+    int32 NumHits = 0;
+    for (int32 s = 0; s < Ends.Num(); ++s)
+    {
+        const FVector& End = Ends[s];
+        if (FMath::PointDistToSegmentSquared(Center, Start, End) > BoundsRadiusSquared)
+            continue;
+
+        FRewindHit& OutHit = OutHits[s];
+        const FVector Direction = (End - Start).GetSafeNormal();
+        for (int32 i = 0; i < NumHitboxes; ++i)
+        {
+            FVector OnShot, OnCapsule;
+            FMath::SegmentDistToSegmentSafe(Start, End, A[i], B[i], OnShot, OnCapsule);
+            const float DistanceSquared = FVector::DistSquared(OnShot, OnCapsule);
+            if (DistanceSquared > FMath::Square(Radii[i]))
+                continue;
+
+            // Move back from the closest point to where the shot enters the capsule
+            const float Penetration = FMath::Sqrt(FMath::Square(Radii[i]) - DistanceSquared);
+            const float Distance = FMath::Max(FVector::Dist(Start, OnShot) - Penetration, 0.f);
+            if (Distance < OutHit.Distance)
+            {
+                OutHit.Distance = Distance;
+                OutHit.ImpactPoint = Start + Direction * Distance;
+                OutHit.HitboxIndex = i;
+            }
+        }
+        if (OutHit.HitboxIndex != INDEX_NONE)
+            ++NumHits;
+    }
+    return NumHits;
+}
@@ -23,64 +23,98 @@ void UOpenShooterAnimInstance::NativeUpdateAnimation(float DeltaSeconds)
     {
         OpenShooterCharacter = Cast<AOpenShooterCharacter>(TryGetPawnOwner());
     }
-    if (OpenShooterCharacter == nullptr)
-        return;
-
-    FVector Velocity = OpenShooterCharacter->GetVelocity();
-    Velocity.Z = 0;    // We only want the horizontal velocity
-    Speed = Velocity.Size();
+    Snapshot.bValid = OpenShooterCharacter != nullptr;
+    if (Snapshot.bValid)
+        GatherSnapshot();
+}
 
-    bIsInAir = OpenShooterCharacter->GetCharacterMovement()->IsFalling();
-    bIsAccelerating = OpenShooterCharacter->GetCharacterMovement()->GetCurrentAcceleration().Size() > 0;
-    bIsCrouched = OpenShooterCharacter->bIsCrouched;
-    bIsAiming = OpenShooterCharacter->IsAiming();
-    TurningInPlace = OpenShooterCharacter->GetTurningInPlace();
-    bRotateRootBone = OpenShooterCharacter->ShouldRotateRootBone();
-    bEliminated = OpenShooterCharacter->IsEliminated();
+void UOpenShooterAnimInstance::GatherSnapshot()
+{
+    const UCharacterMovementComponent* Movement = OpenShooterCharacter->GetCharacterMovement();
+    Snapshot.Velocity = OpenShooterCharacter->GetVelocity();
+    Snapshot.bIsFalling = Movement->IsFalling();
+    Snapshot.bIsAccelerating = Movement->GetCurrentAcceleration().SizeSquared() > 0.f;
+    Snapshot.bIsCrouched = OpenShooterCharacter->bIsCrouched;
+    Snapshot.bIsAiming = OpenShooterCharacter->IsAiming();
+    Snapshot.TurningInPlace = OpenShooterCharacter->GetTurningInPlace();
+    Snapshot.bRotateRootBone = OpenShooterCharacter->ShouldRotateRootBone();
+    Snapshot.bEliminated = OpenShooterCharacter->IsEliminated();
+    Snapshot.AimRotation = OpenShooterCharacter->GetBaseAimRotation();
+    Snapshot.ActorRotation = OpenShooterCharacter->GetActorRotation();
+    Snapshot.AimOffsetYaw = OpenShooterCharacter->GetAimOffsetYaw();
+    Snapshot.AimOffsetPitch = OpenShooterCharacter->GetAimOffsetPitch();
+    Snapshot.CombatState = OpenShooterCharacter->GetCombatState();
+    Snapshot.bLocallyControlled = OpenShooterCharacter->IsLocallyControlled();
+    Snapshot.bReducedDetail = bReducedDetail;
 
     EquippedWeapon = OpenShooterCharacter->GetEquippedWeapon();
-    bWeaponEquipped = OpenShooterCharacter->IsWeaponEquipped();
+    Snapshot.bWeaponEquipped = OpenShooterCharacter->IsWeaponEquipped();
+    const UMeshComponent* WeaponMesh = EquippedWeapon ? EquippedWeapon->GetMesh() : nullptr;
+    const USkeletalMeshComponent* Mesh = OpenShooterCharacter->GetMesh();
+    Snapshot.bHasWeaponMesh = Snapshot.bWeaponEquipped && WeaponMesh && Mesh;
+    if (Snapshot.bHasWeaponMesh && !Snapshot.bReducedDetail)
+    {
+        // The socket and bone transforms live on the components, so they are read here. Everything else is done off the game thread
+        Snapshot.LeftHandSocket = WeaponMesh->GetSocketTransform(FName("LeftHandSocket"), ERelativeTransformSpace::RTS_World);
+        Snapshot.RightHandBone = Mesh->GetSocketTransform(FName("hand_r"), ERelativeTransformSpace::RTS_World);
+        if (Snapshot.bLocallyControlled)
+        {
+            Snapshot.RightHandSocket = WeaponMesh->GetSocketTransform(FName("RightHandSocket"), ERelativeTransformSpace::RTS_World);
+            Snapshot.HitTarget = OpenShooterCharacter->GetHitTarget();
+        }
+    }
+}
+
+void UOpenShooterAnimInstance::NativeThreadSafeUpdateAnimation(float DeltaSeconds)
+{
+    Super::NativeThreadSafeUpdateAnimation(DeltaSeconds);
+
+    if (!Snapshot.bValid)
+        return;
+
+    Speed = Snapshot.Velocity.Size2D();    // We only want the horizontal velocity
+
+    bIsInAir = Snapshot.bIsFalling;
+    bIsAccelerating = Snapshot.bIsAccelerating;
+    bIsCrouched = Snapshot.bIsCrouched;
+    bIsAiming = Snapshot.bIsAiming;
+    TurningInPlace = Snapshot.TurningInPlace;
+    bRotateRootBone = Snapshot.bRotateRootBone;
+    bEliminated = Snapshot.bEliminated;
+    bWeaponEquipped = Snapshot.bWeaponEquipped;
 
     // Offset Yaw for strafing
-    const FRotator AimRotation = OpenShooterCharacter->GetBaseAimRotation();
-    const FRotator MovementRotation = UKismetMathLibrary::MakeRotFromX(OpenShooterCharacter->GetVelocity());
-    YawOffset = UKismetMathLibrary::NormalizedDeltaRotator(MovementRotation, AimRotation).Yaw;
+    const FRotator MovementRotation = UKismetMathLibrary::MakeRotFromX(Snapshot.Velocity);
+    YawOffset = UKismetMathLibrary::NormalizedDeltaRotator(MovementRotation, Snapshot.AimRotation).Yaw;
 
     // Lean
     CharacterRotationLastFrame = CharacterRotation;
-    CharacterRotation = OpenShooterCharacter->GetActorRotation();
+    CharacterRotation = Snapshot.ActorRotation;
     const FRotator Delta = UKismetMathLibrary::NormalizedDeltaRotator(CharacterRotation, CharacterRotationLastFrame);
     const float Target = Delta.Yaw / DeltaSeconds;
     const float Interp = FMath::FInterpTo(Lean, Target, DeltaSeconds, 6.0f);
     Lean = FMath::Clamp(Interp, -90.0f, 90.0f);    // if we mouse quickly, we don't want the lean to be too much
 
     // Aim Offsets
-    AimOffset_Yaw = OpenShooterCharacter->GetAimOffsetYaw();
-    AimOffset_Pitch = OpenShooterCharacter->GetAimOffsetPitch();
+    AimOffset_Yaw = Snapshot.AimOffsetYaw;
+    AimOffset_Pitch = Snapshot.AimOffsetPitch;
 
-    if (bWeaponEquipped && EquippedWeapon && EquippedWeapon->GetMesh() && OpenShooterCharacter->GetMesh())
+    // Reduced detail: the hands are left to the animation (see the toggles below)
+    if (Snapshot.bHasWeaponMesh && !Snapshot.bReducedDetail)
     {
-        LeftHandTransform =
-            EquippedWeapon->GetMesh()->GetSocketTransform(FName("LeftHandSocket"), ERelativeTransformSpace::RTS_World);
         // We want the socket location to be relative to the right hand. This is because the weapon should not be asjusted or moved
-        // relative to the right hand at runtime. The right hand is our reference in the bone space
-        FVector LeftHandTargetLocation;
-        FRotator LeftHandTargetRotation;
-        OpenShooterCharacter->GetMesh()->TransformToBoneSpace(FName("hand_r"), LeftHandTransform.GetLocation(),
-            FRotator::ZeroRotator, LeftHandTargetLocation, LeftHandTargetRotation);
-        // Now we set the location and the rotation of the left hand to the target transform
-        LeftHandTransform.SetLocation(LeftHandTargetLocation);
-        LeftHandTransform.SetRotation(LeftHandTargetRotation.Quaternion());
+        // relative to the right hand at runtime. The right hand is our reference in the bone space (what TransformToBoneSpace does)
+        LeftHandTransform = Snapshot.LeftHandSocket;
+        LeftHandTransform.SetLocation(Snapshot.RightHandBone.InverseTransformPosition(Snapshot.LeftHandSocket.GetLocation()));
+        LeftHandTransform.SetRotation(Snapshot.RightHandBone.GetRotation().Inverse());
 
         // We want the right hand to look at the hit target, because the aim offset is not matching with the crosshair
-        if (OpenShooterCharacter->IsLocallyControlled())
+        bLocallyControlled = Snapshot.bLocallyControlled;
+        if (bLocallyControlled)
         {    // we don't waste computation on the server. The client will tell the server where it's shooting
-            bLocallyControlled = true;
-            FTransform RightHandTransform =
-                EquippedWeapon->GetMesh()->GetSocketTransform(FName("RightHandSocket"), ERelativeTransformSpace::RTS_World);
-
-            const FRotator LookAtRotation = UKismetMathLibrary::FindLookAtRotation(RightHandTransform.GetLocation(),
-                RightHandTransform.GetLocation() + (RightHandTransform.GetLocation() - OpenShooterCharacter->GetHitTarget()));
+            const FVector RightHandLocation = Snapshot.RightHandSocket.GetLocation();
+            const FRotator LookAtRotation = UKismetMathLibrary::FindLookAtRotation(
+                RightHandLocation, RightHandLocation + (RightHandLocation - Snapshot.HitTarget));
 
             // We interpolate the rotation of the right hand towards the hit target so we don't see the hand snapping to a new
             // rotation
@@ -94,14 +128,19 @@ void UOpenShooterAnimInstance::NativeUpdateAnimation(float DeltaSeconds)
         // MuzzleTipTransform.GetLocation(), MuzzleTipTransform.GetLocation() + MuzzleX * 1000, FColor::Red, false, 0.1f, 0, 1);
         // DrawDebugLine(GetWorld(), MuzzleTipTransform.GetLocation(), OpenShooterCharacter->GetHitTarget(), FColor::Yellow, false,
         // 0.1f, 0, 1);
+    }
+
+    if (Snapshot.bHasWeaponMesh)
+    {
+        const bool bReloading = Snapshot.CombatState == ECombatState::ECS_Reloading;
 
         // We need to disable the IK when reloading, so we use this variable in the blueprint
-        bUseFABRIK = OpenShooterCharacter->GetCombatState() != ECombatState::ECS_Reloading;
+        bUseFABRIK = !bReloading && !Snapshot.bReducedDetail;
 
         // we need to disable the aim offsets when reloading, so we use this variable in the blueprint
-        bUseAimOffsets = OpenShooterCharacter->GetCombatState() != ECombatState::ECS_Reloading;
+        bUseAimOffsets = !bReloading;
 
         // We need to disable the right hand rotation when reloading, so we use this variable in the blueprint
-        bTransformRightHand = OpenShooterCharacter->GetCombatState() != ECombatState::ECS_Reloading;
+        bTransformRightHand = !bReloading && !Snapshot.bReducedDetail;
     }
 }
@@ -4,6 +4,8 @@
 
 #include "Camera/CameraComponent.h"
 #include "Character/CombatComponent.h"
+#include "Character/LagCompensationComponent.h"
+#include "Character/OpenShooterMovementComponent.h"
 #include "Character/OpenShooterPlayerController.h"
 #include "Components/CapsuleComponent.h"
 #include "Components/WidgetComponent.h"
@@ -16,11 +18,16 @@
 #include "InputActionValue.h"
 #include "Kismet/GameplayStatics.h"
 #include "Kismet/KismetMathLibrary.h"
+#include "Net/Core/PushModel/PushModel.h"
 #include "Net/UnrealNetwork.h"
 #include "OpenShooter.h"
 #include "OpenShooterGameMode.h"
 #include "OpenShooterPlayerState.h"
+#include "SkeletalMeshComponentBudgeted.h"
 #include "Sound/SoundCue.h"
+#include "Subsystems/AnimationBudgetSubsystem.h"
+#include "Subsystems/CharacterSignificanceSubsystem.h"
+#include "Subsystems/NetProfilerSubsystem.h"
 #include "Weapon/Weapon.h"
 
 DEFINE_LOG_CATEGORY(LogTemplateCharacter);
@@ -28,7 +35,11 @@ DEFINE_LOG_CATEGORY(LogTemplateCharacter);
 //////////////////////////////////////////////////////////////////////////
 // AOpenShooterCharacter
 
-AOpenShooterCharacter::AOpenShooterCharacter()
+AOpenShooterCharacter::AOpenShooterCharacter(const FObjectInitializer& ObjectInitializer)
+    // A budgeted mesh, so the animation of the simulated proxies can be throttled (see UAnimationBudgetSubsystem), and a movement
+    // component that predicts the aim speed
+    : Super(ObjectInitializer.SetDefaultSubobjectClass<USkeletalMeshComponentBudgeted>(ACharacter::MeshComponentName)
+                .SetDefaultSubobjectClass<UOpenShooterMovementComponent>(ACharacter::CharacterMovementComponentName))
 {
     PrimaryActorTick.bCanEverTick = true;    // we need this for combat component to tick
 
@@ -44,6 +55,10 @@ AOpenShooterCharacter::AOpenShooterCharacter()
     GetCharacterMovement()->bOrientRotationToMovement = true;               // Character moves in the direction of input...
     GetCharacterMovement()->RotationRate = FRotator(0.0f, 500.0f, 0.0f);    // ...at this rotation rate
 
+    // Only the simulated proxies are budgeted, UAnimationBudgetSubsystem registers them itself
+    if (USkeletalMeshComponentBudgeted* BudgetedMesh = Cast<USkeletalMeshComponentBudgeted>(GetMesh()))
+        BudgetedMesh->SetAutoRegisterWithBudgetAllocator(false);
+
     // Create a camera boom (pulls in towards the player if there is a collision)
     CameraBoom = CreateDefaultSubobject<USpringArmComponent>(TEXT("CameraBoom"));
     CameraBoom->SetupAttachment(GetMesh());
@@ -71,6 +86,9 @@ AOpenShooterCharacter::AOpenShooterCharacter()
     // We want the combat component to replicate because it has replicated variables.
     // The component itself needs to be replicated for it to have replicated variables.
 
+    // Not replicated: the hitbox history only lives on the server
+    LagCompensation = CreateDefaultSubobject<ULagCompensationComponent>(TEXT("LagCompensation"));
+
     // Enable crouching
     GetCharacterMovement()->GetNavAgentPropertiesRef().bCanCrouch = true;
     GetCharacterMovement()->SetCrouchedHalfHeight(60.0f);
@@ -88,7 +106,7 @@ AOpenShooterCharacter::AOpenShooterCharacter()
     // Set character to not rotate in place initially
     TurningInPlace = ETurningInPlace::ETIP_NotTurning;
 
-    // Set net update frequency
+    // Net update frequency while active. Idle characters go down to IdleNetUpdateFrequency (see UpdateNetActivity)
     NetUpdateFrequency = 66.0f;
     MinNetUpdateFrequency = 33.0f;
 
@@ -105,9 +123,20 @@ void AOpenShooterCharacter::GetLifetimeReplicatedProps(TArray<FLifetimeProperty>
 
     // We need to replicate the OverlappingWeapon so that the client can show the pickup widget, but only the owner can interact
     // with it so the widget is only shown on the client that owns the character
-    DOREPLIFETIME_CONDITION(AOpenShooterCharacter, OverlappingWeapon, COND_OwnerOnly);
+    // Both are push based: the net driver only compares them after we mark them dirty
+    FDoRepLifetimeParams Params;
+    Params.bIsPushBased = true;
+    Params.Condition = COND_OwnerOnly;
+    DOREPLIFETIME_WITH_PARAMS_FAST(AOpenShooterCharacter, OverlappingWeapon, Params);
 
-    DOREPLIFETIME(AOpenShooterCharacter, Health);
+    Params.Condition = COND_None;
+    DOREPLIFETIME_WITH_PARAMS_FAST(AOpenShooterCharacter, HealthState, Params);
+}
+
+bool AOpenShooterCharacter::CallRemoteFunction(UFunction* Function, void* Parameters, FOutParmRec* OutParms, FFrame* Stack)
+{
+    FNetProfileRPCScope ProfileScope(this, Function);
+    return Super::CallRemoteFunction(Function, Parameters, OutParms, Stack);
 }
 
 void AOpenShooterCharacter::BeginPlay()
@@ -120,7 +149,26 @@ void AOpenShooterCharacter::BeginPlay()
 
     // We bind the OnTakeAnyDamage event to the ReceiveDamage function only for server
     if (HasAuthority())
+    {
         OnTakeAnyDamage.AddDynamic(this, &AOpenShooterCharacter::ReceiveDamage);
+        HealthState.Health = static_cast<uint16>(FMath::CeilToInt(Health));
+        MARK_PROPERTY_DIRTY_FROM_NAME(AOpenShooterCharacter, HealthState, this);
+    }
+
+    if (UAnimationBudgetSubsystem* AnimationBudget = GetWorld()->GetSubsystem<UAnimationBudgetSubsystem>())
+        AnimationBudget->Register(this);
+    if (UCharacterSignificanceSubsystem* Significance = GetWorld()->GetSubsystem<UCharacterSignificanceSubsystem>())
+        Significance->Register(this);
+}
+
+void AOpenShooterCharacter::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+    if (UAnimationBudgetSubsystem* AnimationBudget = GetWorld()->GetSubsystem<UAnimationBudgetSubsystem>())
+        AnimationBudget->Unregister(this);
+    if (UCharacterSignificanceSubsystem* Significance = GetWorld()->GetSubsystem<UCharacterSignificanceSubsystem>())
+        Significance->Unregister(this);
+
+    Super::EndPlay(EndPlayReason);
 }
 
 void AOpenShooterCharacter::PostInitializeComponents()
@@ -128,6 +176,8 @@ void AOpenShooterCharacter::PostInitializeComponents()
     Super::PostInitializeComponents();
     if (Combat)
         Combat->Character = this;
+    if (LagCompensation)
+        LagCompensation->Character = this;
 }
 
 void AOpenShooterCharacter::Tick(float DeltaSeconds)
@@ -138,20 +188,23 @@ void AOpenShooterCharacter::Tick(float DeltaSeconds)
     {
         // Setting the aim offset
         AimOffset(DeltaSeconds);
-    }    // for simulated proxy it's done in OnRep_ReplicatedMovement which is run only when necessary
+    }
+    else if (GetLocalRole() == ROLE_SimulatedProxy)
+    {
+        // The aim pitch and the turn in place come from the snapshot buffer, a little in the past
+        SimProxiesTurn();
+    }
     else
     {
-        TimeSinceLastMovementReplication += DeltaSeconds;
-        // We keep track of this because if this value  reaches a certain amount, we force call OnRep_ReplicatedMovement
-        if (TimeSinceLastMovementReplication > 0.25f)
-        {
-            OnRep_ReplicatedMovement();
-        }
-
-        // we calculate the pitch at every frame
-        CalculateAimOffsetPitch();
+        // Server: the pitch of the remote players is needed for their hitboxes
+        AimOffset_Pitch = CalculateAimOffsetPitch();
     }
 
+    if (HasAuthority())
+        UpdateNetActivity();
+
+    UpdateHitReacts();
+
     HideCameraIfCharacterClose();
 
     PollInit();    // Poll and initialize any relevant data for the beginning of the game (HUD, etc.)
@@ -232,6 +285,7 @@ void AOpenShooterCharacter::SetOverlappingWeapon(AWeapon* Weapon)
 
     // set the overlapping weapon
     OverlappingWeapon = Weapon;
+    MARK_PROPERTY_DIRTY_FROM_NAME(AOpenShooterCharacter, OverlappingWeapon, this);
     // on the client, OnRep_OverlappingWeapon would be called, but not on the server
     // so we need to call it manually on the server
     if (IsLocallyControlled())
@@ -251,6 +305,33 @@ bool AOpenShooterCharacter::IsAiming() const
     return Combat && Combat->bAiming;
 }
 
+bool AOpenShooterCharacter::IsNetActive() const
+{
+    return GetWorld()->GetTimeSeconds() - LastNetActivityTime < NetActivityTimeout;
+}
+
+void AOpenShooterCharacter::UpdateNetActivity()
+{
+    const float Now = GetWorld()->GetTimeSeconds();
+    const bool bMoving = GetVelocity().SizeSquared() > FMath::Square(10.f);
+    const bool bFiring = Combat && Now - Combat->LastFireTime < NetActivityTimeout;
+    const FRotator AimRotation = GetBaseAimRotation();
+    const bool bTurning = !AimRotation.Equals(LastNetActivityRotation, NetActivityRotationThreshold);
+    LastNetActivityRotation = AimRotation;
+    if (bMoving || bTurning || IsAiming() || bFiring)
+        LastNetActivityTime = Now;
+
+    // The class default is the rate of an active character
+    const bool bActive = IsNetActive();
+    const float Frequency = bActive ? GetClass()->GetDefaultObject<AActor>()->NetUpdateFrequency : IdleNetUpdateFrequency;
+    if (NetUpdateFrequency == Frequency)
+        return;
+
+    NetUpdateFrequency = Frequency;
+    if (bActive)
+        ForceNetUpdate();    // don't wait for the idle period to run out
+}
+
 void AOpenShooterCharacter::PlayFireMontage(const bool bAiming) const
 {
     if (Combat == nullptr || Combat->EquippedWeapon == nullptr)
@@ -275,7 +356,7 @@ void AOpenShooterCharacter::PlayReloadMontage() const
     {
         AnimInstance->Montage_Play(ReloadMontage, 1.0f);
         FName Section;
-        switch (GetEquippedWeapon()->GetWeaponType())
+        switch (Combat->GetEquippedWeaponType())
         {
             case EWeaponType::EWT_AssaultRifle:
                 Section = FName("AssaultRifle");
@@ -288,7 +369,7 @@ void AOpenShooterCharacter::PlayReloadMontage() const
     }
 }
 
-void AOpenShooterCharacter::PlayHitReactMontage() const
+void AOpenShooterCharacter::PlayHitReactMontage(const EHitDirection Direction) const
 {
     if (Combat == nullptr || Combat->EquippedWeapon == nullptr)
         return;
@@ -297,19 +378,93 @@ void AOpenShooterCharacter::PlayHitReactMontage() const
     if (AnimInstance && HitReactMontage)
     {
         AnimInstance->Montage_Play(HitReactMontage, 1.0f);
-        FName SectionName("FromFront");
-        AnimInstance->Montage_JumpToSection(SectionName, HitReactMontage);
+        FName SectionName;
+        switch (Direction)
+        {
+            case EHitDirection::EHD_Back:
+                SectionName = FName("FromBack");
+                break;
+            case EHitDirection::EHD_Left:
+                SectionName = FName("FromLeft");
+                break;
+            case EHitDirection::EHD_Right:
+                SectionName = FName("FromRight");
+                break;
+            default:
+                SectionName = FName("FromFront");
+                break;
+        }
+        // A montage without the directional sections keeps playing its first one
+        if (HitReactMontage->IsValidSectionName(SectionName))
+            AnimInstance->Montage_JumpToSection(SectionName, HitReactMontage);
     }
 }
 
-void AOpenShooterCharacter::OnRep_ReplicatedMovement()
+void AOpenShooterCharacter::QueueHitReacts(const int32 Count, const EHitDirection Direction)
 {
-    Super::OnRep_ReplicatedMovement();
+    if (Count <= 0)
+        return;
+    // Don't wait for the interval if nothing was playing
+    if (PendingHitReacts == 0)
+        NextHitReactTime = FMath::Min(NextHitReactTime, GetWorld()->GetTimeSeconds());
+    PendingHitReacts = FMath::Min(PendingHitReacts + Count, MaxPendingHitReacts);
+    PendingHitDirection = Direction;
+}
 
-    // We need to run the simulated proxies' turn in place only when necessary instead of doing in tick (because tick is not
-    // fast enough)
-    SimProxiesTurn();
-    TimeSinceLastMovementReplication = 0.f;
+void AOpenShooterCharacter::UpdateHitReacts()
+{
+    const float Now = GetWorld()->GetTimeSeconds();
+    if (PendingHitReacts == 0 || Now < NextHitReactTime)
+        return;
+
+    PlayHitReactMontage(PendingHitDirection);
+    --PendingHitReacts;
+    NextHitReactTime = Now + HitReactInterval;
+}
+
+EHitDirection AOpenShooterCharacter::GetHitDirection(const AActor* DamageCauser) const
+{
+    if (DamageCauser == nullptr)
+        return EHitDirection::EHD_Front;
+
+    // Against a projectile's flight, otherwise towards the causer (a hit scan weapon is in the shooter's hands)
+    const FVector CauserVelocity = DamageCauser->GetVelocity();
+    const FVector ToHit = CauserVelocity.IsNearlyZero() ? DamageCauser->GetActorLocation() - GetActorLocation() : -CauserVelocity;
+    const FVector Direction = ToHit.GetSafeNormal2D();
+
+    const float Forward = FVector::DotProduct(GetActorForwardVector(), Direction);
+    const float Right = FVector::DotProduct(GetActorRightVector(), Direction);
+    if (FMath::Abs(Forward) >= FMath::Abs(Right))
+        return Forward >= 0.f ? EHitDirection::EHD_Front : EHitDirection::EHD_Back;
+    return Right >= 0.f ? EHitDirection::EHD_Right : EHitDirection::EHD_Left;
+}
+
+EWeaponType AOpenShooterCharacter::GetDamageCauserWeaponType(const AActor* DamageCauser)
+{
+    // A hit scan weapon is the causer itself, a projectile is owned by the shooter
+    if (const AWeapon* Weapon = Cast<AWeapon>(DamageCauser))
+        return Weapon->GetWeaponType();
+    if (const AOpenShooterCharacter* Shooter = DamageCauser ? Cast<AOpenShooterCharacter>(DamageCauser->GetOwner()) : nullptr)
+        if (const AWeapon* Weapon = Shooter->GetEquippedWeapon())
+            return Weapon->GetWeaponType();
+    return EWeaponType::EWT_MAX;
+}
+
+void AOpenShooterCharacter::PostNetReceive()
+{
+    Super::PostNetReceive();
+
+    if (GetLocalRole() != ROLE_SimulatedProxy)
+        return;
+
+    // Called once all the properties of the update are applied, so the view pitch is there even when the movement did not change
+    FProxySnapshot Snapshot;
+    Snapshot.Time = GetWorld()->GetTimeSeconds();
+    Snapshot.Yaw = GetActorRotation().Yaw;
+    Snapshot.Pitch = CalculateAimOffsetPitch();
+    Snapshot.Speed = CalculateSpeed();
+    Snapshot.bInAir = GetCharacterMovement()->IsFalling();
+    ProxySnapshots.Add(Snapshot, ProxyMaxSnapshotGap);
 }
 
 void AOpenShooterCharacter::Move(const FInputActionValue& Value)
@@ -390,19 +545,20 @@ void AOpenShooterCharacter::AimReleased()
         Combat->SetAiming(false);
 }
 
-void AOpenShooterCharacter::CalculateAimOffsetPitch()
+float AOpenShooterCharacter::CalculateAimOffsetPitch() const
 {
-    AimOffset_Pitch = GetBaseAimRotation().Pitch;
+    float Pitch = GetBaseAimRotation().Pitch;
     // If the character is not locally controlled, the pitch and yaw values are packaged together by the CharacterMovememntComponent
     // Therefore the pitch ends up being not in [-90, 90] range. We need to adjust it only if the character is not locally
     // controlled
-    if (!IsLocallyControlled() && AimOffset_Pitch > 90.f)
+    if (!IsLocallyControlled() && Pitch > 90.f)
     {
         // we re-map the pitch from [270, 360) to [-90, 0)
         const FVector2D InRange(270.f, 360.f);
         const FVector2D OutRange(-90.f, 0.f);
-        AimOffset_Pitch = FMath::GetMappedRangeValueClamped(InRange, OutRange, AimOffset_Pitch);
+        Pitch = FMath::GetMappedRangeValueClamped(InRange, OutRange, Pitch);
     }
+    return Pitch;
 }
 
 float AOpenShooterCharacter::CalculateSpeed() const
@@ -444,44 +600,42 @@ void AOpenShooterCharacter::AimOffset(float DeltaSeconds)
         bUseControllerRotationYaw = true;    // we want the controller to rotate the camera
     }
 
-    CalculateAimOffsetPitch();
+    AimOffset_Pitch = CalculateAimOffsetPitch();
 }
 
 void AOpenShooterCharacter::SimProxiesTurn()
 {
+    FProxySnapshot Snapshot;
+    float YawRate = 0.f;
+    const float Delay = FMath::Max(ProxyInterpolationDelay, ProxySnapshots.GetArrivalInterval() * ProxyInterpolationIntervals);
+    const float RenderTime = GetWorld()->GetTimeSeconds() - Delay;
+    if (!ProxySnapshots.Sample(RenderTime, ProxyMaxExtrapolation, Snapshot, YawRate))
+    {
+        // Nothing received yet
+        AimOffset_Pitch = CalculateAimOffsetPitch();
+        return;
+    }
+    AimOffset_Pitch = Snapshot.Pitch;
+
     if (Combat == nullptr || Combat->EquippedWeapon == nullptr)
         return;
 
     bRotateRootBone = false;
 
-    if (const float Speed = CalculateSpeed(); Speed > 0.f)
+    if (Snapshot.Speed > 0.f || Snapshot.bInAir)
     {
         TurningInPlace = ETurningInPlace::ETIP_NotTurning;
         return;
     }
 
-    // At this point, the simulated proxies cannot turn in place, so we need to simulate it
-    ProxyRotationLastFrame = ProxyRotation;
-    ProxyRotation = GetActorRotation();
-    ProxyYaw = UKismetMathLibrary::NormalizedDeltaRotator(ProxyRotation, ProxyRotationLastFrame).Yaw;
-
-    if (FMath::Abs(ProxyYaw) > TurnThreshold)
-    {
-        if (ProxyYaw > TurnThreshold)
-        {
-            TurningInPlace = ETurningInPlace::ETIP_Right;
-        }
-        else if (ProxyYaw < -TurnThreshold)
-        {
-            TurningInPlace = ETurningInPlace::ETIP_Left;
-        }
-        else
-        {    // in between
-            TurningInPlace = ETurningInPlace::ETIP_NotTurning;
-        }
-        return;
-    }
-    TurningInPlace = ETurningInPlace::ETIP_NotTurning;    // not enough turn, so do not turn in place
+    // At this point, the simulated proxies cannot turn in place, so we need to simulate it. The rate is 0 once the updates
+    // stopped for longer than the extrapolation, so the proxy stops turning by itself
+    if (YawRate > ProxyTurnRateThreshold)
+        TurningInPlace = ETurningInPlace::ETIP_Right;
+    else if (YawRate < -ProxyTurnRateThreshold)
+        TurningInPlace = ETurningInPlace::ETIP_Left;
+    else
+        TurningInPlace = ETurningInPlace::ETIP_NotTurning;    // not enough turn, so do not turn in place
 }
 
 void AOpenShooterCharacter::TurnInPlace(float DeltaSeconds)
@@ -600,20 +754,33 @@ void AOpenShooterCharacter::UpdateHUDHealth()
         PlayerController->SetHUDHealth(Health, MaxHealth);
 }
 
-void AOpenShooterCharacter::MulticastPlayImpactEffects_Implementation(FVector_NetQuantize ImpactPoint)
+void AOpenShooterCharacter::PlayHitEffects(UWorld* World, const FVector& ImpactPoint) const
 {
     if (HitSound)
-        UGameplayStatics::PlaySoundAtLocation(this, HitSound, ImpactPoint);
+        UGameplayStatics::PlaySoundAtLocation(World, HitSound, ImpactPoint);
     if (HitParticles)
-        UGameplayStatics::SpawnEmitterAtLocation(this, HitParticles, ImpactPoint);
+        UGameplayStatics::SpawnEmitterAtLocation(World, HitParticles, ImpactPoint);
 }
 
-void AOpenShooterCharacter::OnRep_Health()
+void AOpenShooterCharacter::UpdateHealthState(const EHitDirection HitDirection)
 {
-    // This will be called on the clients when the Health variable is updated on the server
+    HealthState.Health = static_cast<uint16>(FMath::CeilToInt(Health));
+    HealthState.HitCount = (HealthState.HitCount + 1) & FHealthRepState::HitCountMask;
+    HealthState.LastHitDirection = HitDirection;
+    MARK_PROPERTY_DIRTY_FROM_NAME(AOpenShooterCharacter, HealthState, this);
+}
+
+void AOpenShooterCharacter::OnRep_HealthState()
+{
+    // This will be called on the clients when the health state is updated on the server
+    Health = HealthState.Health;
+
+    // We play a hit react montage for every hit since the last update
+    const int32 NewHits = bHealthStateReceived ? (HealthState.HitCount - ReceivedHitCount) & FHealthRepState::HitCountMask : 0;
+    ReceivedHitCount = HealthState.HitCount;
+    bHealthStateReceived = true;
+    QueueHitReacts(NewHits, HealthState.LastHitDirection);
 
-    // We play the hit react montage
-    PlayHitReactMontage();
     // We update the health on the HUD
     UpdateHUDHealth();
 }
@@ -622,10 +789,12 @@ void AOpenShooterCharacter::ReceiveDamage(
     AActor* DamagedActor, float Damage, const UDamageType* DamageType, AController* InstigatorController, AActor* DamageCauser)
 {
     Health = FMath::Clamp(Health - Damage, 0.f, MaxHealth);
-    // This will call the OnRep_Health function on the clients but we need to do the same things in the server
+    const EHitDirection HitDirection = GetHitDirection(DamageCauser);
+    UpdateHealthState(HitDirection);
+    // This will call the OnRep_HealthState function on the clients but we need to do the same things in the server
 
     // We play the hit react montage
-    PlayHitReactMontage();
+    QueueHitReacts(1, HitDirection);
     // We update the health on the HUD
     UpdateHUDHealth();
 
@@ -640,12 +809,16 @@ void AOpenShooterCharacter::ReceiveDamage(
 
             if (PlayerController)
             {
-                AOpenShooterPlayerState* AttackerPlayerState =
-                    AttackerController ? Cast<AOpenShooterPlayerState>(AttackerController->PlayerState) : nullptr;
-                const FString AttackerName = AttackerPlayerState ? AttackerPlayerState->GetPlayerName() : TEXT("???");
-                const FString DefeatMessage = FString::Printf(TEXT("<AttackerName>%s</> killed you!"), *AttackerName);
-                AOpenShooterPlayerState* ThisPlayerState = Cast<AOpenShooterPlayerState>(PlayerController->PlayerState);
-                ThisPlayerState->SetAnnoucementMessage(DefeatMessage);
+                // Only the attacker and the weapon are sent, the victim's client formats the message
+                APlayerState* AttackerPlayerState = AttackerController ? AttackerController->PlayerState : nullptr;
+                const EWeaponType WeaponType = GetDamageCauserWeaponType(DamageCauser);
+                if (AOpenShooterPlayerState* ThisPlayerState = Cast<AOpenShooterPlayerState>(PlayerController->PlayerState))
+                {
+                    ThisPlayerState->SetAnnoucementMessage(WeaponType == EWeaponType::EWT_MAX
+                                                               ? EAnnouncementMessage::EAM_Eliminated
+                                                               : EAnnouncementMessage::EAM_EliminatedWith,
+                        AttackerPlayerState, WeaponType);
+                }
             }
         }
     }
@@ -0,0 +1,91 @@
+// Copyright (c) 2024 Rasna Studios. All rights reserved.
+
+#include "Character/OpenShooterMovementComponent.h"
+
+#include "Character/CombatComponent.h"
+#include "Character/OpenShooterCharacter.h"
+
+float UOpenShooterMovementComponent::GetMaxSpeed() const
+{
+    if (bWantsToAim && IsMovingOnGround() && !IsCrouching())
+        return MaxWalkSpeedAiming;
+    return Super::GetMaxSpeed();
+}
+
+void UOpenShooterMovementComponent::UpdateFromCompressedFlags(const uint8 Flags)
+{
+    Super::UpdateFromCompressedFlags(Flags);
+
+    const bool bWasAiming = bWantsToAim;
+    bWantsToAim = (Flags & FSavedMove_Character::FLAG_Custom_0) != 0;
+
+    // On the server this runs for the moves of the client, on the client for the replays
+    if (bWantsToAim == bWasAiming || CharacterOwner == nullptr || CharacterOwner->GetLocalRole() != ROLE_Authority)
+        return;
+    if (const AOpenShooterCharacter* Character = Cast<AOpenShooterCharacter>(CharacterOwner))
+        if (UCombatComponent* Combat = Character->GetCombat())
+            Combat->SetAiming(bWantsToAim);
+}
+
+bool UOpenShooterMovementComponent::ClientUpdatePositionAfterServerUpdate()
+{
+    // The replays apply the aiming of each saved move: the input of this frame must survive them
+    const bool bRealWantsToAim = bWantsToAim;
+    const bool bResult = Super::ClientUpdatePositionAfterServerUpdate();
+    bWantsToAim = bRealWantsToAim;
+    return bResult;
+}
+
+FNetworkPredictionData_Client* UOpenShooterMovementComponent::GetPredictionData_Client() const
+{
+    if (ClientPredictionData == nullptr)
+    {
+        UOpenShooterMovementComponent* MutableThis = const_cast<UOpenShooterMovementComponent*>(this);
+        MutableThis->ClientPredictionData = new FNetworkPredictionData_Client_OpenShooter(*this);
+    }
+    return ClientPredictionData;
+}
+
+// = Saved move =
+
+void FSavedMove_OpenShooter::Clear()
+{
+    Super::Clear();
+    bSavedWantsToAim = false;
+}
+
+uint8 FSavedMove_OpenShooter::GetCompressedFlags() const
+{
+    uint8 Flags = Super::GetCompressedFlags();
+    if (bSavedWantsToAim)
+        Flags |= FLAG_Custom_0;
+    return Flags;
+}
+
+bool FSavedMove_OpenShooter::CanCombineWith(const FSavedMovePtr& NewMove, ACharacter* InCharacter, const float MaxDelta) const
+{
+    // The move where the aiming changes must reach the server on its own, so the speed changes at the same time there
+    if (bSavedWantsToAim != static_cast<const FSavedMove_OpenShooter*>(NewMove.Get())->bSavedWantsToAim)
+        return false;
+    return Super::CanCombineWith(NewMove, InCharacter, MaxDelta);
+}
+
+void FSavedMove_OpenShooter::SetMoveFor(
+    ACharacter* C, const float InDeltaTime, FVector const& NewAccel, FNetworkPredictionData_Client_Character& ClientData)
+{
+    Super::SetMoveFor(C, InDeltaTime, NewAccel, ClientData);
+
+    if (const UOpenShooterMovementComponent* Movement = Cast<UOpenShooterMovementComponent>(C->GetCharacterMovement()))
+        bSavedWantsToAim = Movement->WantsToAim();
+}
+
+FNetworkPredictionData_Client_OpenShooter::FNetworkPredictionData_Client_OpenShooter(
+    const UCharacterMovementComponent& ClientMovement)
+    : Super(ClientMovement)
+{
+}
+
+FSavedMovePtr FNetworkPredictionData_Client_OpenShooter::AllocateNewMove()
+{
+    return FSavedMovePtr(new FSavedMove_OpenShooter());
+}
@@ -8,6 +8,8 @@
 #include "Components/TextBlock.h"
 #include "HUD/CharacterOverlay.h"
 #include "HUD/OpenShooterHUD.h"
+#include "Subsystems/ImpactEventSubsystem.h"
+#include "Subsystems/NetProfilerSubsystem.h"
 
 void AOpenShooterPlayerController::BeginPlay()
 {
@@ -17,6 +19,67 @@ void AOpenShooterPlayerController::BeginPlay()
     ClearAnnoucementText();
 }
 
+void AOpenShooterPlayerController::Tick(float DeltaSeconds)
+{
+    Super::Tick(DeltaSeconds);
+
+    CheckTimeSync(DeltaSeconds);
+}
+
+void AOpenShooterPlayerController::ReceivedPlayer()
+{
+    Super::ReceivedPlayer();
+
+    if (IsLocalController())
+        ServerRequestServerTime(GetWorld()->GetTimeSeconds());
+}
+
+bool AOpenShooterPlayerController::CallRemoteFunction(UFunction* Function, void* Parameters, FOutParmRec* OutParms, FFrame* Stack)
+{
+    FNetProfileRPCScope ProfileScope(this, Function);
+    return Super::CallRemoteFunction(Function, Parameters, OutParms, Stack);
+}
+
+void AOpenShooterPlayerController::CheckTimeSync(const float DeltaSeconds)
+{
+    // The clocks drift over time, so we re-sync every TimeSyncFrequency seconds
+    TimeSyncRunningTime += DeltaSeconds;
+    if (IsLocalController() && TimeSyncRunningTime > TimeSyncFrequency)
+    {
+        ServerRequestServerTime(GetWorld()->GetTimeSeconds());
+        TimeSyncRunningTime = 0.f;
+    }
+}
+
+float AOpenShooterPlayerController::GetServerTime() const
+{
+    if (HasAuthority())
+        return GetWorld()->GetTimeSeconds();
+    return GetWorld()->GetTimeSeconds() + ClientServerDelta;
+}
+
+void AOpenShooterPlayerController::ServerRequestServerTime_Implementation(const float TimeOfClientRequest)
+{
+    const float ServerTimeOfReceipt = GetWorld()->GetTimeSeconds();
+    ClientReportServerTime(TimeOfClientRequest, ServerTimeOfReceipt);
+}
+
+void AOpenShooterPlayerController::ClientReportServerTime_Implementation(
+    const float TimeOfClientRequest, const float TimeServerReceivedClientRequest)
+{
+    // We assume the trip to the server takes as long as the trip back
+    const float RoundTripTime = GetWorld()->GetTimeSeconds() - TimeOfClientRequest;
+    SingleTripTime = 0.5f * RoundTripTime;
+    const float CurrentServerTime = TimeServerReceivedClientRequest + SingleTripTime;
+    ClientServerDelta = CurrentServerTime - GetWorld()->GetTimeSeconds();
+}
+
+void AOpenShooterPlayerController::ClientPlayImpacts_Implementation(const FImpactBatch& Batch)
+{
+    if (const UImpactEventSubsystem* Impacts = GetWorld()->GetSubsystem<UImpactEventSubsystem>())
+        Impacts->PlayImpacts(Batch);
+}
+
 void AOpenShooterPlayerController::OnPossess(APawn* InPawn)
 {
     Super::OnPossess(InPawn);
@@ -63,13 +126,13 @@ void AOpenShooterPlayerController::SetHUDDefeats(int32 Defeats)
     }
 }
 
-void AOpenShooterPlayerController::SetHUDAnnoucement(const FString& Message, const float DisplayTime)
+void AOpenShooterPlayerController::SetHUDAnnoucement(const FText& Message, const float DisplayTime)
 {
     HUD = HUD == nullptr ? Cast<AOpenShooterHUD>(GetHUD()) : HUD;
 
     if (HUD && HUD->CharacterOverlay && HUD->CharacterOverlay->AnnouncementText)
     {
-        HUD->CharacterOverlay->AnnouncementText->SetText(FText::FromString(Message));
+        HUD->CharacterOverlay->AnnouncementText->SetText(Message);
         HUD->CharacterOverlay->AnnouncementText->SetVisibility(ESlateVisibility::Visible);
 
         // Start a timer to hide the text after DisplayTime seconds
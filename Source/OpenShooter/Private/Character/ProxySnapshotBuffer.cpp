@@ -0,0 +1,90 @@
+// Copyright (c) 2024 Rasna Studios. All rights reserved.
+
+#include "Character/ProxySnapshotBuffer.h"
+
+void FProxySnapshotBuffer::Add(const FProxySnapshot& Snapshot, const float MaxGap)
+{
+    if (Num > 0)
+    {
+        const FProxySnapshot& Newest = Get(Num - 1);
+        // Several updates in the same frame: keep the last one
+        if (Snapshot.Time <= Newest.Time)
+        {
+            Snapshots[(First + Num - 1) % Capacity] = Snapshot;
+            return;
+        }
+        // Nothing was received for a while because nothing changed: the proxy was still in its previous state until now
+        const float Gap = Snapshot.Time - Newest.Time;
+        if (Gap > MaxGap)
+        {
+            FProxySnapshot Held = Newest;
+            Held.Time = Snapshot.Time - MaxGap;
+            Push(Held);
+        }
+        else
+        {
+            ArrivalInterval = ArrivalInterval > 0.f ? FMath::Lerp(ArrivalInterval, Gap, 0.1f) : Gap;
+        }
+    }
+    Push(Snapshot);
+}
+
+void FProxySnapshotBuffer::Push(const FProxySnapshot& Snapshot)
+{
+    if (Num == Capacity)
+    {
+        First = (First + 1) % Capacity;
+        --Num;
+    }
+    Snapshots[(First + Num) % Capacity] = Snapshot;
+    ++Num;
+}
+
+bool FProxySnapshotBuffer::Sample(
+    const float Time, const float MaxExtrapolation, FProxySnapshot& OutSnapshot, float& OutYawRate) const
+{
+    OutYawRate = 0.f;
+    if (Num == 0)
+        return false;
+
+    if (Time <= Get(0).Time || Num == 1)
+    {
+        OutSnapshot = Get(0);
+        return true;
+    }
+
+    // Interpolate between the two snapshots around Time
+    for (int32 i = 1; i < Num; ++i)
+    {
+        const FProxySnapshot& A = Get(i - 1);
+        const FProxySnapshot& B = Get(i);
+        if (Time >= B.Time)
+            continue;
+
+        const float Duration = B.Time - A.Time;
+        const float Alpha = (Time - A.Time) / Duration;
+        const float DeltaYaw = FMath::FindDeltaAngleDegrees(A.Yaw, B.Yaw);
+        OutSnapshot.Time = Time;
+        OutSnapshot.Yaw = FRotator::NormalizeAxis(A.Yaw + DeltaYaw * Alpha);
+        OutSnapshot.Pitch = FMath::Lerp(A.Pitch, B.Pitch, Alpha);
+        OutSnapshot.Speed = FMath::Lerp(A.Speed, B.Speed, Alpha);
+        OutSnapshot.bInAir = Alpha < 0.5f ? A.bInAir : B.bInAir;
+        OutYawRate = DeltaYaw / Duration;
+        return true;
+    }
+
+    // Past the newest snapshot: keep going at the last rates for a while, then hold
+    const FProxySnapshot& A = Get(Num - 2);
+    const FProxySnapshot& B = Get(Num - 1);
+    const float Duration = B.Time - A.Time;
+    const float Extrapolation = FMath::Min(Time - B.Time, MaxExtrapolation);
+    const float YawRate = FMath::FindDeltaAngleDegrees(A.Yaw, B.Yaw) / Duration;
+    OutSnapshot = B;
+    OutSnapshot.Time = Time;
+    OutSnapshot.Yaw = FRotator::NormalizeAxis(B.Yaw + YawRate * Extrapolation);
+    OutSnapshot.Pitch = FMath::Clamp(B.Pitch + (B.Pitch - A.Pitch) / Duration * Extrapolation, -90.f, 90.f);
+    OutSnapshot.Speed = FMath::Max(B.Speed + (B.Speed - A.Speed) / Duration * Extrapolation, 0.f);
+    if (Time - B.Time < MaxExtrapolation)
+        OutYawRate = YawRate;
+    return true;
+}
@@ -0,0 +1,90 @@
+// Copyright (c) 2024 Rasna Studios. All rights reserved.
+
+#include "HUD/Announcement.h"
+
+#include "GameFramework/PlayerState.h"
+#include "Internationalization/TextFormatter.h"
+#include "Subsystems/NetProfilerSubsystem.h"
+
+#define LOCTEXT_NAMESPACE "Announcement"
+
+namespace
+{
+// The announcement table, indexed by message id. Compiled once on first use: FTextFormat recompiles by itself when the
+// culture changes, so the cache never goes stale
+const FTextFormat& GetAnnouncementTemplate(const EAnnouncementMessage Message)
+{
+    static const FTextFormat Templates[] = {
+        FTextFormat(FText::GetEmpty()),
+        FTextFormat(LOCTEXT("Eliminated", "<AttackerName>{Player}</> killed you!")),
+        FTextFormat(LOCTEXT("EliminatedWith", "<AttackerName>{Player}</> killed you with the {Weapon}!")),
+    };
+    static_assert(UE_ARRAY_COUNT(Templates) == static_cast<int32>(EAnnouncementMessage::EAM_MAX), "Missing announcement");
+
+    return Templates[static_cast<int32>(Message)];
+}
+
+// The weapon names, indexed by weapon type. The enum display names are editor only metadata, so they are not localized
+// and are missing from packaged builds
+const FText& GetWeaponName(const EWeaponType WeaponType)
+{
+    static const FText Names[] = {
+        LOCTEXT("AssaultRifle", "Assault Rifle"),
+        LOCTEXT("Shotgun", "Shotgun"),
+    };
+    static_assert(UE_ARRAY_COUNT(Names) == static_cast<int32>(EWeaponType::EWT_MAX), "Missing weapon name");
+
+    return Names[static_cast<int32>(WeaponType)];
+}
+}    // namespace
+
+FText FAnnouncement::Format() const
+{
+    if (IsEmpty())
+        return FText::GetEmpty();
+
+    FFormatNamedArguments Arguments;
+    Arguments.Add(TEXT("Player"), Player ? FText::FromString(Player->GetPlayerName()) : LOCTEXT("UnknownPlayer", "???"));
+    if (WeaponType != EWeaponType::EWT_MAX)
+        Arguments.Add(TEXT("Weapon"), GetWeaponName(WeaponType));
+    return FText::Format(GetAnnouncementTemplate(Message), Arguments);
+}
+
+bool FAnnouncement::NetSerialize(FArchive& Ar, UPackageMap* Map, bool& bOutSuccess)
+{
+    FNetProfilePropertyScope ProfileScope(TEXT("Announcement"), *this, Ar, Map);
+    bOutSuccess = true;
+
+    // [0-3] message, [4-6] weapon type, [7-10] serial
+    uint32 Packed = 0;
+    if (Ar.IsSaving())
+        Packed = static_cast<uint32>(Message) | static_cast<uint32>(WeaponType) << 4 | (Serial & SerialMask) << 7;
+    Ar.SerializeBits(&Packed, 7 + SerialBits);
+    if (Ar.IsLoading())
+    {
+        Message = static_cast<EAnnouncementMessage>(Packed & 15);
+        WeaponType = static_cast<EWeaponType>((Packed >> 4) & 7);
+        Serial = static_cast<uint8>((Packed >> 7) & SerialMask);
+        if (Message >= EAnnouncementMessage::EAM_MAX || WeaponType > EWeaponType::EWT_MAX)
+        {
+            bOutSuccess = false;
+            return false;
+        }
+    }
+
+    // Clearing the announcement does not need the player
+    if (IsEmpty())
+    {
+        if (Ar.IsLoading())
+            Player = nullptr;
+        return true;
+    }
+
+    UObject* PlayerObject = Player;
+    Map->SerializeObject(Ar, APlayerState::StaticClass(), PlayerObject);
+    if (Ar.IsLoading())
+        Player = Cast<APlayerState>(PlayerObject);
+    return true;
+}
+
+#undef LOCTEXT_NAMESPACE
@@ -4,6 +4,7 @@
 
 #include "Blueprint/UserWidget.h"
 #include "HUD/CharacterOverlay.h"
+#include "Subsystems/NetProfilerSubsystem.h"
 
 void AOpenShooterHUD::DrawHUD()
 {
@@ -42,6 +43,8 @@ void AOpenShooterHUD::DrawHUD()
             DrawCrosshair(HUDPackage.CrosshairsBottom, ViewportCenter, Spread, HUDPackage.CrosshairColor);
         }
     }
+
+    DrawNetProfile();
 }
 
 void AOpenShooterHUD::BeginPlay()
@@ -62,6 +65,33 @@ void AOpenShooterHUD::AddCharacterOverlay()
     }
 }
 
+void AOpenShooterHUD::DrawNetProfile()
+{
+    const int32 NumLines = UNetProfilerSubsystem::GetOverlayLines();
+    const UNetProfilerSubsystem* Profiler = NumLines > 0 ? GetWorld()->GetSubsystem<UNetProfilerSubsystem>() : nullptr;
+    if (Profiler == nullptr)
+        return;
+
+    TArray<FNetProfileRow> Rows;
+    Profiler->GetRows(Rows);
+
+    constexpr float X = 20.f;
+    constexpr float LineHeight = 14.f;
+    float Y = 120.f;
+    DrawText(TEXT("Net profile: last second | average over a minute"), FLinearColor::Yellow, X, Y);
+    Y += LineHeight;
+    DrawText(TEXT("Property lines: HealthState, CombatRepState and Announcement only"), FLinearColor::Yellow, X, Y);
+    for (int32 i = 0; i < FMath::Min(NumLines, Rows.Num()); ++i)
+    {
+        const FNetProfileRow& Row = Rows[i];
+        Y += LineHeight;
+        const FString Line = FString::Printf(TEXT("%s %s %s [%s]: %lld B/s %d/s | %.1f B/s"),
+            *UEnum::GetDisplayValueAsText(Row.Category).ToString(), Row.bSent ? TEXT("Out") : TEXT("In"), *Row.Name.ToString(),
+            *Row.Connection, Row.Bytes1s, Row.Count1s, static_cast<double>(Row.Bytes60s) / UNetProfilerSubsystem::WindowSeconds);
+        DrawText(Line, FLinearColor::White, X, Y);
+    }
+}
+
 void AOpenShooterHUD::DrawCrosshair(
     UTexture2D* Texture, const FVector2D ViewportCenter, const FVector2D Spread, const FLinearColor CrosshairColor)
 {
@@ -4,15 +4,21 @@
 
 #include "Character/OpenShooterCharacter.h"
 #include "Character/OpenShooterPlayerController.h"
+#include "Net/Core/PushModel/PushModel.h"
 #include "Net/UnrealNetwork.h"
 
 void AOpenShooterPlayerState::GetLifetimeReplicatedProps(TArray<class FLifetimeProperty>& OutLifetimeProps) const
 {
     Super::GetLifetimeReplicatedProps(OutLifetimeProps);    // This replicates the score
 
-    // We need to replicate the defeats so that the client can show the defeats in the HUD
-    DOREPLIFETIME(AOpenShooterPlayerState, Defeats);
-    DOREPLIFETIME_CONDITION(AOpenShooterPlayerState, AnnoucementMessage, COND_OwnerOnly);
+    // We need to replicate the defeats so that the client can show the defeats in the HUD.
+    // Push based: they are only compared after we mark them dirty
+    FDoRepLifetimeParams Params;
+    Params.bIsPushBased = true;
+    DOREPLIFETIME_WITH_PARAMS_FAST(AOpenShooterPlayerState, Defeats, Params);
+
+    Params.Condition = COND_OwnerOnly;
+    DOREPLIFETIME_WITH_PARAMS_FAST(AOpenShooterPlayerState, Annoucement, Params);
 }
 
 void AOpenShooterPlayerState::AddToScore(const float Amount)
@@ -28,6 +34,7 @@ void AOpenShooterPlayerState::AddToScore(const float Amount)
 void AOpenShooterPlayerState::AddToDefeats(const int32 Amount)
 {
     Defeats += Amount;
+    MARK_PROPERTY_DIRTY_FROM_NAME(AOpenShooterPlayerState, Defeats, this);
 
     // Update the HUD to reflect the new defeats
     UpdateHUD(nullptr, &Defeats);
@@ -50,41 +57,37 @@ void AOpenShooterPlayerState::OnRep_Defeats()
 
 void AOpenShooterPlayerState::OnRep_AnnounceMessage()
 {
-    Character = Character ? Character : Cast<AOpenShooterCharacter>(GetPawn());
-    if (Character)
-    {
-        Controller = Controller ? Controller : Cast<AOpenShooterPlayerController>(Character->GetController());
-        if (Controller)
-        {
-            Controller->SetHUDAnnoucement(AnnoucementMessage);
-        }
-    }
+    ShowAnnoucement();
 }
 
-void AOpenShooterPlayerState::SetAnnoucementMessage(const FString& Message)
+void AOpenShooterPlayerState::SetAnnoucementMessage(
+    const EAnnouncementMessage Message, APlayerState* Player, const EWeaponType WeaponType)
 {
-    AnnoucementMessage = Message;    // triggers OnRep_AnnounceMessage
-    Character = Character ? Character : Cast<AOpenShooterCharacter>(GetPawn());
-    if (Character)
-    {
-        Controller = Controller ? Controller : Cast<AOpenShooterPlayerController>(Character->GetController());
-        if (Controller)
-        {
-            Controller->SetHUDAnnoucement(AnnoucementMessage);
-        }
-    }
+    Annoucement.Message = Message;    // triggers OnRep_AnnounceMessage
+    Annoucement.Player = Player;
+    Annoucement.WeaponType = WeaponType;
+    Annoucement.Serial = (Annoucement.Serial + 1) & FAnnouncement::SerialMask;    // the same message twice still replicates
+    MARK_PROPERTY_DIRTY_FROM_NAME(AOpenShooterPlayerState, Annoucement, this);
+    ShowAnnoucement();
 }
 
 void AOpenShooterPlayerState::ClearAnnoucementMessage()
 {
-    AnnoucementMessage = "";    // triggers OnRep_AnnounceMessage
+    SetAnnoucementMessage(EAnnouncementMessage::EAM_None, nullptr);    // triggers OnRep_AnnounceMessage
+}
+
+void AOpenShooterPlayerState::ShowAnnoucement()
+{
     Character = Character ? Character : Cast<AOpenShooterCharacter>(GetPawn());
     if (Character)
     {
         Controller = Controller ? Controller : Cast<AOpenShooterPlayerController>(Character->GetController());
-        if (Controller)
+        if (Controller && Controller->IsLocalController())
         {
-            Controller->ClearAnnoucementText();
+            if (Annoucement.IsEmpty())
+                Controller->ClearAnnoucementText();
+            else
+                Controller->SetHUDAnnoucement(Annoucement.Format());
         }
     }
 }
@@ -0,0 +1,20 @@
+// Copyright (c) 2024 Rasna Studios. All rights reserved.
+
+#include "Replication/NetBitCounter.h"
+
+bool FNetBitCounter::bCounting = false;
+
+UPackageMap* FNetBitCounter::GetPackageMap()
+{
+    // Stateless, so the class defaults will do
+    return GetMutableDefault<UNetBitCounterPackageMap>();
+}
+
+bool UNetBitCounterPackageMap::SerializeObject(FArchive& Ar, UClass* InClass, UObject*& Obj, FNetworkGUID* OutNetGUID)
+{
+    // The NetGUIDs of the objects spawned during a match stay in the thousands, which packs in 2 bytes
+    constexpr uint32 TypicalNetGUID = 1 << 12;
+    uint32 Value = Obj ? TypicalNetGUID : 0;
+    Ar.SerializeIntPacked(Value);
+    return true;
+}
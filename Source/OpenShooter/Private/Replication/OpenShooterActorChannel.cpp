@@ -0,0 +1,45 @@
+// Copyright (c) 2024 Rasna Studios. All rights reserved.
+
+#include "Replication/OpenShooterActorChannel.h"
+
+#include "Engine/NetConnection.h"
+#include "Net/DataBunch.h"
+#include "Subsystems/NetProfilerSubsystem.h"
+
+UOpenShooterActorChannel::UOpenShooterActorChannel(const FObjectInitializer& ObjectInitializer) : Super(ObjectInitializer)
+{
+}
+
+FPacketIdRange UOpenShooterActorChannel::SendBunch(FOutBunch* Bunch, const bool Merge)
+{
+    if (UNetProfilerSubsystem* Profiler = Bunch ? UNetProfilerSubsystem::Get(Connection) : nullptr)
+    {
+        const int64 Bits = Bunch->GetNumBits();
+        if (Actor)
+            Profiler->Record(ENetProfileCategory::ENPC_Actor, Actor->GetClass()->GetFName(), Connection, true, Bits);
+
+        // Sent while calling an RPC (the bunch opening the channel may carry the actor too)
+        const FName RPC = FNetProfileRPCScope::GetCurrent();
+        if (!RPC.IsNone())
+        {
+            Profiler->Record(ENetProfileCategory::ENPC_RPC, RPC, Connection, true, Bits);
+            FNetProfileRPCScope::MarkSent();
+        }
+    }
+
+    return Super::SendBunch(Bunch, Merge);
+}
+
+void UOpenShooterActorChannel::ReceivedBunch(FInBunch& Bunch)
+{
+    const int64 Bits = Bunch.GetNumBits();
+
+    Super::ReceivedBunch(Bunch);
+
+    // After the super: the first bunch is the one that spawns the actor
+    if (UNetProfilerSubsystem* Profiler = UNetProfilerSubsystem::Get(Connection))
+    {
+        const FName ClassName = Actor ? Actor->GetClass()->GetFName() : FName(TEXT("Unknown"));
+        Profiler->Record(ENetProfileCategory::ENPC_Actor, ClassName, Connection, false, Bits);
+    }
+}
@@ -0,0 +1,270 @@
+// Copyright (c) 2024 Rasna Studios. All rights reserved.
+
+#include "Replication/OpenShooterReplicationGraph.h"
+
+#include "Character/OpenShooterCharacter.h"
+#include "Engine/LevelScriptActor.h"
+#include "GameFramework/Info.h"
+#include "GameFramework/PlayerController.h"
+#include "GameFramework/PlayerState.h"
+#include "OpenShooter.h"
+#include "Weapon/Projectile.h"
+#include "Weapon/Weapon.h"
+
+DECLARE_DWORD_COUNTER_STAT(TEXT("Characters At Full Rate"), STAT_CharactersFullRate, STATGROUP_OpenShooter);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Characters Idle"), STAT_CharactersIdle, STATGROUP_OpenShooter);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Characters Far"), STAT_CharactersFar, STATGROUP_OpenShooter);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Characters Hidden"), STAT_CharactersHidden, STATGROUP_OpenShooter);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Character Visibility Traces"), STAT_CharacterVisibilityTraces, STATGROUP_OpenShooter);
+
+static TAutoConsoleVariable<int32> CVarAdaptiveCharacterRate(TEXT("OpenShooter.Net.AdaptiveCharacterRate"), 1,
+    TEXT("1: characters replicate to each connection at a rate depending on their activity, distance and visibility.\n")
+    TEXT("0: characters always replicate at their class rate"));
+
+void UOpenShooterReplicationGraph::InitGlobalActorClassSettings()
+{
+    Super::InitGlobalActorClassSettings();
+
+    // Our own classes
+    ClassRepNodePolicies.Set(AOpenShooterCharacter::StaticClass(), EClassRepNodeMapping::Spatialize_Dynamic);
+    ClassRepNodePolicies.Set(AProjectile::StaticClass(), EClassRepNodeMapping::Spatialize_Dynamic);
+    ClassRepNodePolicies.Set(AWeapon::StaticClass(), EClassRepNodeMapping::Spatialize_Dormancy);
+
+    // Engine classes
+    ClassRepNodePolicies.Set(AReplicationGraphDebugActor::StaticClass(), EClassRepNodeMapping::NotRouted);
+    ClassRepNodePolicies.Set(ALevelScriptActor::StaticClass(), EClassRepNodeMapping::NotRouted);
+    ClassRepNodePolicies.Set(APlayerController::StaticClass(), EClassRepNodeMapping::NotRouted);
+    ClassRepNodePolicies.Set(AInfo::StaticClass(), EClassRepNodeMapping::RelevantAllConnections);
+
+    InitClassReplicationInfo(AOpenShooterCharacter::StaticClass(), true);
+    InitClassReplicationInfo(AProjectile::StaticClass(), true);
+    InitClassReplicationInfo(AWeapon::StaticClass(), true);
+    InitClassReplicationInfo(APlayerState::StaticClass(), false);
+
+    // Bits sent per class, in the ReplicationGraph category of the CSV profiler (csvprofile start)
+    CSVTracker.SetExplicitClassTracking(AOpenShooterCharacter::StaticClass(), FName("Character"));
+    CSVTracker.SetExplicitClassTracking(AProjectile::StaticClass(), FName("Projectile"));
+    CSVTracker.SetExplicitClassTracking(AWeapon::StaticClass(), FName("Weapon"));
+}
+
+void UOpenShooterReplicationGraph::InitClassReplicationInfo(UClass* Class, const bool bSpatialize)
+{
+    // Same cull distance and update rate as the default relevancy, taken from the class defaults
+    const AActor* Defaults = Class->GetDefaultObject<AActor>();
+    FClassReplicationInfo Info;
+    if (bSpatialize)
+        Info.SetCullDistanceSquared(Defaults->NetCullDistanceSquared);
+    Info.ReplicationPeriodFrame = GetReplicationPeriodFrameForFrequency(Defaults->NetUpdateFrequency);
+    GlobalActorReplicationInfoMap.SetClassInfo(Class, Info);
+}
+
+EClassRepNodeMapping UOpenShooterReplicationGraph::GetMappingPolicy(UClass* Class)
+{
+    if (const EClassRepNodeMapping* Policy = ClassRepNodePolicies.Get(Class))
+        return *Policy;
+
+    // Anything else follows the relevancy flags of its class defaults
+    const AActor* Defaults = Class->GetDefaultObject<AActor>();
+    EClassRepNodeMapping Policy = EClassRepNodeMapping::Spatialize_Dynamic;
+    if (Defaults->bAlwaysRelevant)
+        Policy = EClassRepNodeMapping::RelevantAllConnections;
+    else if (Defaults->bOnlyRelevantToOwner)
+        Policy = EClassRepNodeMapping::NotRouted;
+    ClassRepNodePolicies.Set(Class, Policy);
+    return Policy;
+}
+
+void UOpenShooterReplicationGraph::InitGlobalGraphNodes()
+{
+    GridNode = CreateNewNode<UReplicationGraphNode_GridSpatialization2D>();
+    GridNode->CellSize = GridCellSize;
+    GridNode->SpatialBias = FVector2D(SpatialBiasX, SpatialBiasY);
+    if (bDisableSpatialRebuilding)
+        GridNode->AddToClassRebuildDenyList(AActor::StaticClass());
+    AddGlobalGraphNode(GridNode);
+
+    AlwaysRelevantNode = CreateNewNode<UReplicationGraphNode_ActorList>();
+    AddGlobalGraphNode(AlwaysRelevantNode);
+}
+
+void UOpenShooterReplicationGraph::InitConnectionGraphNodes(UNetReplicationGraphConnection* RepGraphConnection)
+{
+    Super::InitConnectionGraphNodes(RepGraphConnection);
+
+    UOpenShooterReplicationGraphNode_OwnerRelevant* OwnerRelevantNode =
+        CreateNewNode<UOpenShooterReplicationGraphNode_OwnerRelevant>();
+    AddConnectionGraphNode(OwnerRelevantNode, RepGraphConnection);
+
+    UOpenShooterReplicationGraphNode_AdaptiveRate* AdaptiveRateNode =
+        CreateNewNode<UOpenShooterReplicationGraphNode_AdaptiveRate>();
+    AdaptiveRateNode->Graph = this;
+    AddConnectionGraphNode(AdaptiveRateNode, RepGraphConnection);
+}
+
+void UOpenShooterReplicationGraph::RouteAddNetworkActorToNodes(
+    const FNewReplicatedActorInfo& ActorInfo, FGlobalActorReplicationInfo& GlobalInfo)
+{
+    switch (GetMappingPolicy(ActorInfo.Class))
+    {
+        case EClassRepNodeMapping::RelevantAllConnections:
+            AlwaysRelevantNode->NotifyAddNetworkActor(ActorInfo);
+            break;
+        case EClassRepNodeMapping::Spatialize_Dynamic:
+            GridNode->AddActor_Dynamic(ActorInfo, GlobalInfo);
+            if (AOpenShooterCharacter* Character = Cast<AOpenShooterCharacter>(ActorInfo.Actor))
+                Characters.Add(Character);
+            break;
+        case EClassRepNodeMapping::Spatialize_Dormancy:
+            GridNode->AddActor_Dormancy(ActorInfo, GlobalInfo);
+            break;
+        default:
+            break;
+    }
+}
+
+void UOpenShooterReplicationGraph::RouteRemoveNetworkActorToNodes(const FNewReplicatedActorInfo& ActorInfo)
+{
+    switch (GetMappingPolicy(ActorInfo.Class))
+    {
+        case EClassRepNodeMapping::RelevantAllConnections:
+            AlwaysRelevantNode->NotifyRemoveNetworkActor(ActorInfo);
+            break;
+        case EClassRepNodeMapping::Spatialize_Dynamic:
+            GridNode->RemoveActor_Dynamic(ActorInfo);
+            if (AOpenShooterCharacter* Character = Cast<AOpenShooterCharacter>(ActorInfo.Actor))
+                Characters.RemoveSingleSwap(Character);
+            break;
+        case EClassRepNodeMapping::Spatialize_Dormancy:
+            GridNode->RemoveActor_Dormancy(ActorInfo);
+            break;
+        default:
+            break;
+    }
+}
+
+float UOpenShooterReplicationGraph::GetCharacterNetRate(
+    const AOpenShooterCharacter* Character, const float Distance, const bool bVisible) const
+{
+    float Rate = Character->NetUpdateFrequency;
+    Rate *= FMath::Lerp(1.f, FarRateScale, FMath::GetRangePct(NearDistance, FarDistance, Distance));
+    if (!bVisible)
+        Rate *= HiddenRateScale;
+    return FMath::Max(Rate, CharacterMinNetRate);
+}
+
+bool UOpenShooterReplicationGraph::ConsumeVisibilityTrace(const uint32 ReplicationFrameNum)
+{
+    if (ReplicationFrameNum != VisibilityTraceFrame)
+    {
+        VisibilityTraceFrame = ReplicationFrameNum;
+        VisibilityTracesLeft = MaxVisibilityTracesPerFrame;
+    }
+    if (VisibilityTracesLeft <= 0)
+        return false;
+    --VisibilityTracesLeft;
+    return true;
+}
+
+void UOpenShooterReplicationGraphNode_OwnerRelevant::GatherActorListsForConnection(
+    const FConnectionGatherActorListParameters& Params)
+{
+    ReplicationActorList.Reset();
+
+    auto AddActor = [this](AActor* Actor)
+    {
+        if (Actor && !ReplicationActorList.Contains(Actor))
+            ReplicationActorList.Add(Actor);
+    };
+
+    for (const FNetViewer& Viewer : Params.Viewers)
+    {
+        AddActor(Viewer.InViewer);
+        AddActor(Viewer.ViewTarget);
+
+        if (const APlayerController* PlayerController = Cast<APlayerController>(Viewer.InViewer))
+        {
+            AddActor(PlayerController->PlayerState);
+
+            // The equipped weapon holds the owner's ammo, it must never be culled for its owner
+            if (const AOpenShooterCharacter* Character = Cast<AOpenShooterCharacter>(PlayerController->GetPawn()))
+            {
+                AddActor(PlayerController->GetPawn());
+                AddActor(Character->GetEquippedWeapon());
+            }
+        }
+    }
+
+    Params.OutGatheredReplicationLists.AddReplicationActorList(ReplicationActorList);
+}
+
+void UOpenShooterReplicationGraphNode_AdaptiveRate::GatherActorListsForConnection(
+    const FConnectionGatherActorListParameters& Params)
+{
+    if (Graph == nullptr || Params.Viewers.Num() == 0)
+        return;
+
+    const bool bAdaptive = CVarAdaptiveCharacterRate.GetValueOnGameThread() != 0;
+    const FNetViewer& Viewer = Params.Viewers[0];
+
+    // A few characters per frame: a rate going up waits a couple of frames at most, a rate going down does not matter
+    const TArray<AOpenShooterCharacter*>& Characters = Graph->GetCharacters();
+    const int32 NumCharacters = FMath::Min(Characters.Num(), FMath::Max(Graph->GetMaxCharactersPerFrame(), 1));
+    for (int32 Step = 0; Step < NumCharacters; ++Step)
+    {
+        NextCharacter = NextCharacter < Characters.Num() ? NextCharacter : 0;
+        const AOpenShooterCharacter* Character = Characters[NextCharacter++];
+        if (Character == nullptr)
+            continue;
+
+        float Rate = Character->GetClass()->GetDefaultObject<AActor>()->NetUpdateFrequency;
+        // The viewer's own pawn always gets the full rate
+        const bool bOwnPawn = Character == Viewer.ViewTarget || Character->GetNetConnection() == Viewer.Connection;
+        if (bAdaptive && !bOwnPawn)
+        {
+            const float Distance = FVector::Dist(Viewer.ViewLocation, Character->GetActorLocation());
+            const bool bVisible = IsVisible(Character, Viewer, Params.ReplicationFrameNum);
+            Rate = Graph->GetCharacterNetRate(Character, Distance, bVisible);
+
+            if (!Character->IsNetActive())
+                INC_DWORD_STAT(STAT_CharactersIdle);
+            if (!bVisible)
+                INC_DWORD_STAT(STAT_CharactersHidden);
+            if (Distance > Graph->GetNearDistance())
+                INC_DWORD_STAT(STAT_CharactersFar);
+        }
+        if (Rate >= Character->GetClass()->GetDefaultObject<AActor>()->NetUpdateFrequency)
+            INC_DWORD_STAT(STAT_CharactersFullRate);
+
+        FConnectionReplicationActorInfo& ActorInfo = Params.ConnectionManager.ActorInfoMap.FindOrAdd(Character);
+        const uint16 Period = Graph->GetReplicationPeriodFrameForFrequency(Rate);
+        // When the rate goes up, don't wait for the end of the longer period that was scheduled
+        if (Period < ActorInfo.ReplicationPeriodFrame)
+            ActorInfo.NextReplicationFrameNum = FMath::Min(ActorInfo.NextReplicationFrameNum, Params.ReplicationFrameNum + Period);
+        ActorInfo.ReplicationPeriodFrame = Period;
+    }
+
+    // Forget the characters that were destroyed
+    if (Visibility.Num() > Graph->GetCharacters().Num())
+        for (auto It = Visibility.CreateIterator(); It; ++It)
+            if (!It.Key().IsValid())
+                It.RemoveCurrent();
+}
+
+bool UOpenShooterReplicationGraphNode_AdaptiveRate::IsVisible(
+    const AOpenShooterCharacter* Character, const FNetViewer& Viewer, const uint32 ReplicationFrameNum)
+{
+    FVisibility& Entry = Visibility.FindOrAdd(Character);
+    const float Now = Graph->GetWorld()->GetTimeSeconds();
+    if (Now < Entry.NextCheckTime || !Graph->ConsumeVisibilityTrace(ReplicationFrameNum))
+        return Entry.bVisible;
+
+    INC_DWORD_STAT(STAT_CharacterVisibilityTraces);
+    // Spread the checks over the interval so they don't all come back in the same frame
+    Entry.NextCheckTime = Now + Graph->GetVisibilityCheckInterval() * FMath::FRandRange(0.75f, 1.25f);
+
+    FCollisionQueryParams QueryParams(SCENE_QUERY_STAT(AdaptiveRateVisibility), false, Character);
+    QueryParams.AddIgnoredActor(Viewer.ViewTarget);
+    Entry.bVisible = !Graph->GetWorld()->LineTraceTestByChannel(
+        Viewer.ViewLocation, Character->GetActorLocation(), ECollisionChannel::ECC_Visibility, QueryParams);
+    return Entry.bVisible;
+}
@@ -0,0 +1,145 @@
+// Copyright (c) 2024 Rasna Studios. All rights reserved.
+
+#include "Subsystems/AnimationBudgetSubsystem.h"
+
+#include "AnimationBudgetAllocatorParameters.h"
+#include "Character/OpenShooterAnimInstance.h"
+#include "Character/OpenShooterCharacter.h"
+#include "IAnimationBudgetAllocator.h"
+#include "OpenShooter.h"
+#include "SkeletalMeshComponentBudgeted.h"
+#include "Subsystems/CharacterSignificanceSubsystem.h"
+
+DECLARE_DWORD_COUNTER_STAT(TEXT("Budgeted Anim Meshes"), STAT_BudgetedAnimMeshes, STATGROUP_OpenShooter);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Throttled Anim Meshes"), STAT_ThrottledAnimMeshes, STATGROUP_OpenShooter);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Reduced Detail Anim Meshes"), STAT_ReducedDetailAnimMeshes, STATGROUP_OpenShooter);
+
+bool UAnimationBudgetSubsystem::ShouldCreateSubsystem(UObject* Outer) const
+{
+    // A dedicated server has no camera, its poses are only for the hitboxes
+    return Super::ShouldCreateSubsystem(Outer) && !IsRunningDedicatedServer();
+}
+
+void UAnimationBudgetSubsystem::OnWorldBeginPlay(UWorld& InWorld)
+{
+    Super::OnWorldBeginPlay(InWorld);
+
+    if (IAnimationBudgetAllocator* Allocator = IAnimationBudgetAllocator::Get(&InWorld))
+    {
+        FAnimationBudgetAllocatorParameters Parameters;
+        Parameters.BudgetInMs = BudgetMs;
+        Parameters.MaxTickRate = MaxTickRate;
+        Allocator->SetParameters(Parameters);
+        Allocator->SetEnabled(true);
+    }
+}
+
+void UAnimationBudgetSubsystem::Initialize(FSubsystemCollectionBase& Collection)
+{
+    Super::Initialize(Collection);
+    Collection.InitializeDependency<UCharacterSignificanceSubsystem>();
+
+    PostActorTickHandle = FWorldDelegates::OnWorldPostActorTick.AddUObject(this, &UAnimationBudgetSubsystem::OnWorldPostActorTick);
+}
+
+void UAnimationBudgetSubsystem::Deinitialize()
+{
+    FWorldDelegates::OnWorldPostActorTick.Remove(PostActorTickHandle);
+    Characters.Reset();
+
+    Super::Deinitialize();
+}
+
+void UAnimationBudgetSubsystem::Register(AOpenShooterCharacter* Character)
+{
+    if (Character && FindIndex(Character) == INDEX_NONE)
+        Characters.Add({Character});
+}
+
+void UAnimationBudgetSubsystem::Unregister(AOpenShooterCharacter* Character)
+{
+    const int32 Index = FindIndex(Character);
+    if (Index == INDEX_NONE)
+        return;
+    SetBudgeted(Characters[Index], Cast<USkeletalMeshComponentBudgeted>(Character->GetMesh()), false);
+    Characters.RemoveAtSwap(Index);
+}
+
+void UAnimationBudgetSubsystem::OnWorldPostActorTick(UWorld* World, ELevelTick TickType, float DeltaSeconds)
+{
+    if (World != GetWorld() || Characters.Num() == 0)
+        return;
+
+    const UCharacterSignificanceSubsystem* SignificanceSubsystem = World->GetSubsystem<UCharacterSignificanceSubsystem>();
+    if (SignificanceSubsystem == nullptr)
+        return;
+
+    for (int32 i = Characters.Num() - 1; i >= 0; --i)
+    {
+        FBudgetedCharacter& Entry = Characters[i];
+        AOpenShooterCharacter* Character = Entry.Character.Get();
+        if (Character == nullptr)
+        {
+            Characters.RemoveAtSwap(i);
+            continue;
+        }
+
+        USkeletalMeshComponentBudgeted* Mesh = Cast<USkeletalMeshComponentBudgeted>(Character->GetMesh());
+        if (Mesh == nullptr)
+            continue;
+
+        // The role changes when a pawn is possessed, so we check it every frame
+        SetBudgeted(Entry, Mesh, Character->GetLocalRole() == ROLE_SimulatedProxy);
+        if (!Entry.bBudgeted)
+            continue;
+
+        INC_DWORD_STAT(STAT_BudgetedAnimMeshes);
+        if (!Mesh->IsComponentTickEnabled())    // the allocator skipped this mesh this frame
+            INC_DWORD_STAT(STAT_ThrottledAnimMeshes);
+
+        const float Significance = SignificanceSubsystem->GetSignificance(Character, Entry.SignificanceIndex);
+        Mesh->SetComponentSignificance(Significance);
+
+        const bool bReducedDetail = Entry.bReducedWork || Significance < ReducedDetailSignificance;
+        if (UOpenShooterAnimInstance* AnimInstance = Cast<UOpenShooterAnimInstance>(Mesh->GetAnimInstance()))
+            AnimInstance->SetReducedDetail(bReducedDetail);
+        if (bReducedDetail)
+            INC_DWORD_STAT(STAT_ReducedDetailAnimMeshes);
+    }
+}
+
+void UAnimationBudgetSubsystem::SetBudgeted(FBudgetedCharacter& Entry, USkeletalMeshComponentBudgeted* Mesh, const bool bBudgeted)
+{
+    if (Entry.bBudgeted == bBudgeted || Mesh == nullptr)
+        return;
+    IAnimationBudgetAllocator* Allocator = IAnimationBudgetAllocator::Get(GetWorld());
+    if (Allocator == nullptr)
+        return;
+
+    Entry.bBudgeted = bBudgeted;
+    Entry.bReducedWork = false;
+    if (bBudgeted)
+    {
+        Allocator->RegisterComponent(Mesh);
+        Mesh->OnReduceWork().BindUObject(this, &UAnimationBudgetSubsystem::OnReduceWork);
+    }
+    else
+    {
+        Allocator->UnregisterComponent(Mesh);
+        Mesh->OnReduceWork().Unbind();
+        if (UOpenShooterAnimInstance* AnimInstance = Cast<UOpenShooterAnimInstance>(Mesh->GetAnimInstance()))
+            AnimInstance->SetReducedDetail(false);
+    }
+}
+
+void UAnimationBudgetSubsystem::OnReduceWork(USkeletalMeshComponentBudgeted* Mesh, const bool bReduceWork)
+{
+    const int32 Index = Mesh ? FindIndex(Cast<AOpenShooterCharacter>(Mesh->GetOwner())) : INDEX_NONE;
+    if (Index != INDEX_NONE)
+        Characters[Index].bReducedWork = bReduceWork;
+}
+
+int32 UAnimationBudgetSubsystem::FindIndex(const AOpenShooterCharacter* Character) const
+{
+    return Characters.IndexOfByPredicate([Character](const FBudgetedCharacter& Entry) { return Entry.Character == Character; });
+}
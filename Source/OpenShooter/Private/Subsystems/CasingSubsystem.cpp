@@ -0,0 +1,226 @@
+// Copyright (c) 2024 Rasna Studios. All rights reserved.
+
+#include "Subsystems/CasingSubsystem.h"
+
+#include "Components/InstancedStaticMeshComponent.h"
+#include "Kismet/GameplayStatics.h"
+#include "OpenShooter.h"
+#include "Sound/SoundCue.h"
+#include "Weapon/Casing.h"
+
+DECLARE_CYCLE_STAT(TEXT("Casing Simulation"), STAT_CasingSimulation, STATGROUP_OpenShooter);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Casings Alive"), STAT_CasingsAlive, STATGROUP_OpenShooter);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Casings Recycled"), STAT_CasingsRecycled, STATGROUP_OpenShooter);
+
+void UCasingSubsystem::Initialize(FSubsystemCollectionBase& Collection)
+{
+    Super::Initialize(Collection);
+
+    // Allocate the whole simulation once
+    Positions.SetNumZeroed(MaxCasings);
+    Velocities.SetNumZeroed(MaxCasings);
+    Rotations.Init(FQuat::Identity, MaxCasings);
+    AngularVelocities.SetNumZeroed(MaxCasings);
+    Lifetimes.SetNumZeroed(MaxCasings);
+    Types.Init(INDEX_NONE, MaxCasings);
+    InstanceIndices.Init(INDEX_NONE, MaxCasings);
+    Flags.SetNumZeroed(MaxCasings);
+}
+
+void UCasingSubsystem::Deinitialize()
+{
+    if (IsValid(InstancesOwner))
+        InstancesOwner->Destroy();
+    InstancesOwner = nullptr;
+    CasingTypes.Reset();
+    CasingTypeIndices.Reset();
+
+    Super::Deinitialize();
+}
+
+TStatId UCasingSubsystem::GetStatId() const
+{
+    RETURN_QUICK_DECLARE_CYCLE_STAT(UCasingSubsystem, STATGROUP_Tickables);
+}
+
+int32 UCasingSubsystem::FindOrAddCasingType(const TSubclassOf<ACasing> CasingClass)
+{
+    if (const int32* Index = CasingTypeIndices.Find(CasingClass))
+        return *Index;
+
+    UWorld* World = GetWorld();
+    const ACasing* Defaults = CasingClass->GetDefaultObject<ACasing>();
+    if (World == nullptr || Defaults == nullptr || Defaults->GetMesh() == nullptr)
+        return INDEX_NONE;
+
+    if (!IsValid(InstancesOwner))
+    {
+        FActorSpawnParameters SpawnParams;
+        SpawnParams.ObjectFlags |= RF_Transient;
+        InstancesOwner = World->SpawnActor<AActor>(AActor::StaticClass(), FTransform::Identity, SpawnParams);
+        USceneComponent* Root = NewObject<USceneComponent>(InstancesOwner, TEXT("Root"));
+        InstancesOwner->SetRootComponent(Root);
+        Root->RegisterComponent();
+    }
+
+    // The instanced mesh copies the look of the casing blueprint
+    const UStaticMeshComponent* DefaultMesh = Defaults->GetMeshComponent();
+    UInstancedStaticMeshComponent* Instances = NewObject<UInstancedStaticMeshComponent>(InstancesOwner);
+    Instances->SetStaticMesh(Defaults->GetMesh());
+    for (int32 i = 0; i < DefaultMesh->GetNumOverrideMaterials(); ++i)
+        Instances->SetMaterial(i, DefaultMesh->GetMaterial(i));
+    Instances->SetCollisionEnabled(ECollisionEnabled::NoCollision);
+    Instances->SetCastShadow(false);    // too small to matter
+    Instances->SetMobility(EComponentMobility::Movable);
+    Instances->SetupAttachment(InstancesOwner->GetRootComponent());
+    Instances->RegisterComponent();
+    InstancesOwner->AddInstanceComponent(Instances);
+
+    FCasingType& Type = CasingTypes.AddDefaulted_GetRef();
+    Type.Instances = Instances;
+    Type.ShellSound = Defaults->GetShellSound();
+    Type.EjectionImpulse = Defaults->GetShellEjectionImpulse();
+    Type.Scale = DefaultMesh->GetRelativeScale3D();
+
+    const int32 Index = CasingTypes.Num() - 1;
+    CasingTypeIndices.Add(CasingClass, Index);
+    return Index;
+}
+
+void UCasingSubsystem::EjectCasing(const TSubclassOf<ACasing> CasingClass, const FTransform& EjectTransform)
+{
+    // Casings are purely cosmetic
+    if (CasingClass == nullptr || GetWorld() == nullptr || GetWorld()->GetNetMode() == NM_DedicatedServer)
+        return;
+
+    const int32 TypeIndex = FindOrAddCasingType(CasingClass);
+    if (TypeIndex == INDEX_NONE)
+        return;
+    FCasingType& Type = CasingTypes[TypeIndex];
+
+    // Ring buffer: the next slot is always the oldest one, recycle it if it is still alive
+    const int32 Slot = NextSlot;
+    NextSlot = (NextSlot + 1) % MaxCasings;
+    if (Flags[Slot] & Alive)
+    {
+        FreeSlot(Slot);
+        INC_DWORD_STAT(STAT_CasingsRecycled);
+    }
+
+    // Same ejection as the ACasing actor: along the socket forward vector, with a small random offset
+    FVector RandomOffset = FVector(FMath::RandRange(-5.0f, 5.0f), FMath::RandRange(-5.0f, 5.0f), FMath::RandRange(-5.0f, 5.0f));
+    RandomOffset.Normalize();
+    const FVector EjectionDirection = EjectTransform.GetRotation().GetForwardVector() + RandomOffset * 0.1f;
+
+    Positions[Slot] = EjectTransform.GetLocation();
+    Velocities[Slot] = EjectionDirection * Type.EjectionImpulse;
+    Rotations[Slot] = EjectTransform.GetRotation();
+    AngularVelocities[Slot] = FMath::VRand() * FMath::FRandRange(10.f, 25.f);
+    Lifetimes[Slot] = MaxFlightTime;
+    Types[Slot] = TypeIndex;
+    Flags[Slot] = Alive;
+
+    const FTransform InstanceTransform(Rotations[Slot], Positions[Slot], Type.Scale);
+    if (Type.FreeInstances.Num() > 0)
+    {
+        InstanceIndices[Slot] = Type.FreeInstances.Pop(EAllowShrinking::No);
+        Type.Instances->UpdateInstanceTransform(InstanceIndices[Slot], InstanceTransform, true, true, true);
+    }
+    else
+    {
+        InstanceIndices[Slot] = Type.Instances->AddInstance(InstanceTransform, true);
+    }
+
+    NumAlive++;
+    SET_DWORD_STAT(STAT_CasingsAlive, NumAlive);
+}
+
+void UCasingSubsystem::FreeSlot(const int32 Slot)
+{
+    if (CasingTypes.IsValidIndex(Types[Slot]))
+    {
+        // Hide the instance and keep it for the next casing of this type
+        FCasingType& Type = CasingTypes[Types[Slot]];
+        const FTransform Hidden(FQuat::Identity, Positions[Slot], FVector::ZeroVector);
+        Type.Instances->UpdateInstanceTransform(InstanceIndices[Slot], Hidden, true, true, true);
+        Type.FreeInstances.Add(InstanceIndices[Slot]);
+    }
+    Flags[Slot] = 0;
+    Types[Slot] = INDEX_NONE;
+    InstanceIndices[Slot] = INDEX_NONE;
+    NumAlive--;
+    SET_DWORD_STAT(STAT_CasingsAlive, NumAlive);
+}
+
+void UCasingSubsystem::Tick(const float DeltaTime)
+{
+    Super::Tick(DeltaTime);
+    SCOPE_CYCLE_COUNTER(STAT_CasingSimulation);
+
+    UWorld* World = GetWorld();
+    const FVector Gravity(0.f, 0.f, World->GetGravityZ());
+    const FCollisionQueryParams QueryParams(SCENE_QUERY_STAT(CasingBounce), false);
+
+    // Which instanced meshes need to send the new transforms to the renderer
+    TBitArray<TInlineAllocator<4>> DirtyTypes(false, CasingTypes.Num());
+
+    for (int32 Slot = 0; Slot < MaxCasings; ++Slot)
+    {
+        if ((Flags[Slot] & Alive) == 0)
+            continue;
+
+        Lifetimes[Slot] -= DeltaTime;
+        if (Lifetimes[Slot] <= 0.f)
+        {
+            FreeSlot(Slot);
+            continue;
+        }
+        if (Flags[Slot] & Resting)
+            continue;
+
+        // Ballistic arc
+        Velocities[Slot] += Gravity * DeltaTime;
+        const FVector Start = Positions[Slot];
+        FVector End = Start + Velocities[Slot] * DeltaTime;
+
+        // Ground bounce
+        FHitResult Hit;
+        if (World->LineTraceSingleByChannel(Hit, Start, End, ECC_Visibility, QueryParams))
+        {
+            const FVector Normal = Hit.ImpactNormal;
+            const FVector NormalVelocity = (Velocities[Slot] | Normal) * Normal;
+            const FVector TangentVelocity = Velocities[Slot] - NormalVelocity;
+            Velocities[Slot] = TangentVelocity * Friction - NormalVelocity * Restitution;
+            AngularVelocities[Slot] *= Friction;
+            End = Hit.ImpactPoint + Normal * 0.5f;    // keep it just above the surface
+
+            // Only the first impact plays the sound and starts the countdown
+            if ((Flags[Slot] & PlayedSound) == 0)
+            {
+                Flags[Slot] |= PlayedSound;
+                Lifetimes[Slot] = FMath::Min(Lifetimes[Slot], LifetimeAfterImpact);
+                if (USoundCue* ShellSound = CasingTypes[Types[Slot]].ShellSound)
+                    UGameplayStatics::PlaySoundAtLocation(World, ShellSound, Hit.ImpactPoint);
+            }
+
+            if (Velocities[Slot].SizeSquared() < FMath::Square(RestSpeed))
+                Flags[Slot] |= Resting;
+        }
+        Positions[Slot] = End;
+
+        // Spin
+        const FVector AngularVelocity = AngularVelocities[Slot];
+        const float Angle = AngularVelocity.Size() * DeltaTime;
+        if (Angle > KINDA_SMALL_NUMBER)
+            Rotations[Slot] = FQuat(AngularVelocity.GetUnsafeNormal(), Angle) * Rotations[Slot];
+
+        const FCasingType& Type = CasingTypes[Types[Slot]];
+        Type.Instances->UpdateInstanceTransform(
+            InstanceIndices[Slot], FTransform(Rotations[Slot], Positions[Slot], Type.Scale), true, false, true);
+        DirtyTypes[Types[Slot]] = true;
+    }
+
+    for (int32 i = 0; i < CasingTypes.Num(); ++i)
+        if (DirtyTypes[i])
+            CasingTypes[i].Instances->MarkRenderStateDirty();
+}
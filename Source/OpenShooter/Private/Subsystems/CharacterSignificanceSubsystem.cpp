@@ -0,0 +1,169 @@
+// Copyright (c) 2024 Rasna Studios. All rights reserved.
+
+#include "Subsystems/CharacterSignificanceSubsystem.h"
+
+#include "Camera/PlayerCameraManager.h"
+#include "Character/CombatComponent.h"
+#include "Character/OpenShooterCharacter.h"
+#include "Components/TimelineComponent.h"
+#include "Components/WidgetComponent.h"
+#include "OpenShooter.h"
+
+DECLARE_DWORD_COUNTER_STAT(TEXT("Significance Characters"), STAT_SignificanceCharacters, STATGROUP_OpenShooter);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Significance Throttled Ticks"), STAT_SignificanceThrottledTicks, STATGROUP_OpenShooter);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Significance Disabled Ticks"), STAT_SignificanceDisabledTicks, STATGROUP_OpenShooter);
+DECLARE_FLOAT_COUNTER_STAT(TEXT("Significance Ticks Saved"), STAT_SignificanceTicksSaved, STATGROUP_OpenShooter);
+
+static TAutoConsoleVariable<int32> CVarSignificance(TEXT("OpenShooter.Significance"), 1,
+    TEXT("Lowers the tick rate of the characters, their combat component, overhead widget and dissolve timeline by significance"),
+    ECVF_Default);
+
+void UCharacterSignificanceSubsystem::Initialize(FSubsystemCollectionBase& Collection)
+{
+    Super::Initialize(Collection);
+
+    PostActorTickHandle =
+        FWorldDelegates::OnWorldPostActorTick.AddUObject(this, &UCharacterSignificanceSubsystem::OnWorldPostActorTick);
+}
+
+void UCharacterSignificanceSubsystem::Deinitialize()
+{
+    FWorldDelegates::OnWorldPostActorTick.Remove(PostActorTickHandle);
+    Characters.Reset();
+
+    Super::Deinitialize();
+}
+
+void UCharacterSignificanceSubsystem::Register(AOpenShooterCharacter* Character)
+{
+    if (Character && FindIndex(Character) == INDEX_NONE)
+        Characters.Add({Character});
+}
+
+void UCharacterSignificanceSubsystem::Unregister(AOpenShooterCharacter* Character)
+{
+    const int32 Index = FindIndex(Character);
+    if (Index != INDEX_NONE)
+        Characters.RemoveAtSwap(Index);
+}
+
+float UCharacterSignificanceSubsystem::GetSignificance(const AOpenShooterCharacter* Character) const
+{
+    const int32 Index = FindIndex(Character);
+    return Index != INDEX_NONE ? Characters[Index].Significance : 1.f;
+}
+
+float UCharacterSignificanceSubsystem::GetSignificance(const AOpenShooterCharacter* Character, int32& InOutIndex) const
+{
+    if (!Characters.IsValidIndex(InOutIndex) || Characters[InOutIndex].Character != Character)
+        InOutIndex = FindIndex(Character);
+    return InOutIndex != INDEX_NONE ? Characters[InOutIndex].Significance : 1.f;
+}
+
+int32 UCharacterSignificanceSubsystem::FindIndex(const AOpenShooterCharacter* Character) const
+{
+    return Characters.IndexOfByPredicate([Character](const FCharacterSignificance& Entry) { return Entry.Character == Character; });
+}
+
+void UCharacterSignificanceSubsystem::OnWorldPostActorTick(UWorld* World, ELevelTick TickType, float DeltaSeconds)
+{
+    if (World != GetWorld() || Characters.Num() == 0)
+        return;
+
+    // A dedicated server has no camera: only the locality counts
+    const APlayerController* LocalController = World->GetFirstPlayerController();
+    const APlayerCameraManager* CameraManager = LocalController ? LocalController->PlayerCameraManager.Get() : nullptr;
+    const FVector ViewLocation = CameraManager ? CameraManager->GetCameraLocation() : FVector::ZeroVector;
+    const bool bEnabled = CVarSignificance.GetValueOnGameThread() != 0;
+    const bool bDedicatedServer = World->GetNetMode() == NM_DedicatedServer;
+
+    float TicksSaved = 0.f;
+    for (int32 i = Characters.Num() - 1; i >= 0; --i)
+    {
+        FCharacterSignificance& Entry = Characters[i];
+        AOpenShooterCharacter* Character = Entry.Character.Get();
+        if (Character == nullptr)
+        {
+            Characters.RemoveAtSwap(i);
+            continue;
+        }
+        INC_DWORD_STAT(STAT_SignificanceCharacters);
+
+        // The role changes when a pawn is possessed, so we check it every frame
+        const bool bLocal = Character->IsLocallyControlled();
+        const FVector* View = CameraManager ? &ViewLocation : nullptr;
+        Entry.Significance = bLocal ? 1.f : CalculateSignificance(Character, View);
+        const float Significance = bEnabled ? Entry.Significance : 1.f;
+        const float Interval = GetTickInterval(Significance);
+
+        TicksSaved += SetActorTick(Character, Character->HasAuthority() ? 0.f : Interval, DeltaSeconds);
+        TicksSaved += SetComponentTick(Character->GetCombat(), !bEnabled || bLocal, 0.f, DeltaSeconds);
+
+        const bool bCosmetic = !bEnabled || !bDedicatedServer;
+        const float WidgetInterval = Significance >= HighSignificance ? 0.f : OverHeadWidgetTickInterval;
+        const bool bWidgetVisible = bCosmetic && Significance > 0.f;
+        TicksSaved += SetComponentTick(Character->GetOverHeadWidget(), bWidgetVisible, WidgetInterval, DeltaSeconds);
+
+        // The timeline only ticks while it plays: it activates itself in Play and deactivates once done
+        UTimelineComponent* DissolveTimeline = Character->GetDissolveTimeline();
+        if (DissolveTimeline && DissolveTimeline->IsPlaying())
+            TicksSaved += SetComponentTick(DissolveTimeline, bCosmetic, Interval, DeltaSeconds);
+    }
+
+    SET_FLOAT_STAT(STAT_SignificanceTicksSaved, TicksSaved);
+}
+
+float UCharacterSignificanceSubsystem::CalculateSignificance(
+    const AOpenShooterCharacter* Character, const FVector* ViewLocation) const
+{
+    if (ViewLocation == nullptr)
+        return 0.f;
+
+    const float Distance = FVector::Dist(Character->GetActorLocation(), *ViewLocation);
+    float Significance = 1.f - FMath::Clamp(Distance / FMath::Max(SignificanceMaxDistance, 1.f), 0.f, 1.f);
+    if (!Character->WasRecentlyRendered(0.2f))
+        Significance *= HiddenSignificanceScale;
+    return Significance;
+}
+
+float UCharacterSignificanceSubsystem::GetTickInterval(const float Significance) const
+{
+    if (Significance >= HighSignificance)
+        return 0.f;
+    return Significance >= LowSignificance ? MediumTickInterval : LowTickInterval;
+}
+
+float UCharacterSignificanceSubsystem::SetActorTick(AActor* Actor, const float Interval, const float DeltaSeconds)
+{
+    if (!Actor->PrimaryActorTick.bCanEverTick)
+        return 0.f;
+    if (Actor->GetActorTickInterval() != Interval)
+        Actor->SetActorTickInterval(Interval);
+    if (Interval <= 0.f)
+        return 0.f;
+
+    INC_DWORD_STAT(STAT_SignificanceThrottledTicks);
+    return 1.f - FMath::Min(DeltaSeconds / Interval, 1.f);
+}
+
+float UCharacterSignificanceSubsystem::SetComponentTick(
+    UActorComponent* Component, const bool bEnabled, const float Interval, const float DeltaSeconds)
+{
+    if (Component == nullptr || !Component->PrimaryComponentTick.bCanEverTick)
+        return 0.f;
+    if (Component->IsComponentTickEnabled() != bEnabled)
+        Component->SetComponentTickEnabled(bEnabled);
+    if (!bEnabled)
+    {
+        INC_DWORD_STAT(STAT_SignificanceDisabledTicks);
+        return 1.f;
+    }
+
+    if (Component->GetComponentTickInterval() != Interval)
+        Component->SetComponentTickInterval(Interval);
+    if (Interval <= 0.f)
+        return 0.f;
+
+    INC_DWORD_STAT(STAT_SignificanceThrottledTicks);
+    return 1.f - FMath::Min(DeltaSeconds / Interval, 1.f);
+}
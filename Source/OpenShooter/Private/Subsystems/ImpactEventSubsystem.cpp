@@ -0,0 +1,94 @@
+// Copyright (c) 2024 Rasna Studios. All rights reserved.
+
+#include "Subsystems/ImpactEventSubsystem.h"
+
+#include "Character/OpenShooterCharacter.h"
+#include "Character/OpenShooterPlayerController.h"
+#include "Weapon/Projectile.h"
+
+void UImpactEventSubsystem::Initialize(FSubsystemCollectionBase& Collection)
+{
+    Super::Initialize(Collection);
+
+    PostActorTickHandle = FWorldDelegates::OnWorldPostActorTick.AddUObject(this, &UImpactEventSubsystem::OnWorldPostActorTick);
+}
+
+void UImpactEventSubsystem::Deinitialize()
+{
+    FWorldDelegates::OnWorldPostActorTick.Remove(PostActorTickHandle);
+    PendingImpacts.Reset();
+
+    Super::Deinitialize();
+}
+
+void UImpactEventSubsystem::AddImpact(
+    const FVector& Location, const FRotator& Rotation, const uint8 SurfaceType, const bool bVictim, UClass* Source)
+{
+    if (Source)
+        PendingImpacts.Add({Location, Rotation, SurfaceType, bVictim, Source});
+}
+
+void UImpactEventSubsystem::OnWorldPostActorTick(UWorld* World, ELevelTick TickType, float DeltaSeconds)
+{
+    if (World == GetWorld() && PendingImpacts.Num() > 0)
+        Flush();
+}
+
+void UImpactEventSubsystem::Flush()
+{
+    const float MaxDistanceSquared = FMath::Square(MaxImpactDistance);
+    FImpactBatch Batch;
+    for (FConstPlayerControllerIterator It = GetWorld()->GetPlayerControllerIterator(); It; ++It)
+    {
+        AOpenShooterPlayerController* PlayerController = Cast<AOpenShooterPlayerController>(It->Get());
+        if (PlayerController == nullptr)
+            continue;
+
+        FVector ViewLocation;
+        FRotator ViewRotation;
+        PlayerController->GetPlayerViewPoint(ViewLocation, ViewRotation);
+
+        Batch.Reset();
+        for (const FPendingImpact& Impact : PendingImpacts)
+        {
+            if (FVector::DistSquared(ViewLocation, Impact.Location) > MaxDistanceSquared)
+                continue;
+            if (Batch.Add(Impact.Location, Impact.Rotation, Impact.SurfaceType, Impact.bVictim, Impact.Source))
+                continue;
+
+            // Full: send this one and start another
+            Batch.RecordSent();
+            PlayerController->ClientPlayImpacts(Batch);
+            Batch.Reset();
+            Batch.Add(Impact.Location, Impact.Rotation, Impact.SurfaceType, Impact.bVictim, Impact.Source);
+        }
+        if (Batch.Num() > 0)
+        {
+            Batch.RecordSent();
+            PlayerController->ClientPlayImpacts(Batch);
+        }
+    }
+    PendingImpacts.Reset();
+}
+
+void UImpactEventSubsystem::PlayImpacts(const FImpactBatch& Batch) const
+{
+    UWorld* World = GetWorld();
+    for (const FImpactEvent& Impact : Batch.Impacts)
+    {
+        const UClass* Source = Batch.Sources[Impact.SourceIndex];
+        if (Source == nullptr)
+            continue;
+
+        const EPhysicalSurface SurfaceType = static_cast<EPhysicalSurface>(Impact.SurfaceType);
+        if (Impact.bVictim)
+        {
+            if (const AOpenShooterCharacter* Victim = Cast<AOpenShooterCharacter>(Source->GetDefaultObject()))
+                Victim->PlayHitEffects(World, Impact.Location);
+        }
+        else if (const AProjectile* Projectile = Cast<AProjectile>(Source->GetDefaultObject()))
+        {
+            Projectile->PlayImpactEffects(World, Impact.Location, Impact.Rotation, SurfaceType);
+        }
+    }
+}
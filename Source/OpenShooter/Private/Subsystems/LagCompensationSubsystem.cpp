@@ -0,0 +1,107 @@
+// Copyright (c) 2024 Rasna Studios. All rights reserved.
+
+#include "Subsystems/LagCompensationSubsystem.h"
+
+#include "Character/LagCompensationComponent.h"
+#include "Character/OpenShooterCharacter.h"
+
+void ULagCompensationSubsystem::Register(ULagCompensationComponent* Component)
+{
+    Components.AddUnique(Component);
+}
+
+void ULagCompensationSubsystem::Unregister(ULagCompensationComponent* Component)
+{
+    Components.RemoveSwap(Component);
+}
+
+float ULagCompensationSubsystem::ClampRewindTime(const float FireTime) const
+{
+    const float Now = GetWorld()->GetTimeSeconds();
+    float MaxRewindTime = 0.f;
+    for (const ULagCompensationComponent* Component : Components)
+        MaxRewindTime = FMath::Max(MaxRewindTime, Component->GetMaxRewindTime());
+
+    // A client can not shoot in the future, and we do not rewind further than the history we keep
+    return FMath::Clamp(FireTime, Now - MaxRewindTime, Now);
+}
+
+void ULagCompensationSubsystem::RequestPoseSamples(const FVector& Start, const FVector& End, const float FlightTime)
+{
+    const float RadiusSquared = FMath::Square(PoseSampleRadius);
+    for (ULagCompensationComponent* Component : Components)
+    {
+        const AActor* Owner = Component->GetOwner();
+        if (Owner && FMath::PointDistToSegmentSquared(Owner->GetActorLocation(), Start, End) <= RadiusSquared)
+            Component->RequestPoseSample(Component->GetMaxRewindTime() + FlightTime);
+    }
+}
+
+bool ULagCompensationSubsystem::TraceRewound(
+    const FVector& Start, const FVector& End, const float Time, const AActor* IgnoredActor, FHitResult& OutHit) const
+{
+    TArray<FHitResult> Hits;
+    if (TraceRewoundBatch(Start, MakeArrayView(&End, 1), Time, IgnoredActor, Hits) == 0)
+        return false;
+    OutHit = Hits[0];
+    return true;
+}
+
+int32 ULagCompensationSubsystem::TraceRewoundBatch(const FVector& Start, const TArrayView<const FVector> Ends, const float Time,
+    const AActor* IgnoredActor, TArray<FHitResult>& OutHits) const
+{
+    OutHits.Reset();
+    OutHits.SetNum(Ends.Num());
+
+    // Closest hit per segment and who got hit
+    TArray<FRewindHit, TInlineAllocator<16>> ClosestHits;
+    TArray<const ULagCompensationComponent*, TInlineAllocator<16>> HitComponents;
+    TArray<FRewindHit, TInlineAllocator<16>> CharacterHits;
+    ClosestHits.SetNum(Ends.Num());
+    HitComponents.SetNumZeroed(Ends.Num());
+    CharacterHits.SetNum(Ends.Num());
+    for (FRewindHit& Hit : ClosestHits)
+        Hit.Distance = TNumericLimits<float>::Max();
+
+    for (const ULagCompensationComponent* Component : Components)
+    {
+        const AOpenShooterCharacter* Character = Component->GetCharacter();
+        if (Character == nullptr || Character == IgnoredActor || Character->IsEliminated())
+            continue;
+
+        if (Component->IntersectSegmentsAtTime(Start, Ends, Time, CharacterHits) == 0)
+            continue;
+
+        for (int32 s = 0; s < Ends.Num(); ++s)
+        {
+            if (CharacterHits[s].HitboxIndex != INDEX_NONE && CharacterHits[s].Distance < ClosestHits[s].Distance)
+            {
+                ClosestHits[s] = CharacterHits[s];
+                HitComponents[s] = Component;
+            }
+        }
+    }
+
+    int32 NumHits = 0;
+    for (int32 s = 0; s < Ends.Num(); ++s)
+    {
+        const ULagCompensationComponent* HitComponent = HitComponents[s];
+        if (HitComponent == nullptr)
+            continue;
+
+        const FRewindHit& ClosestHit = ClosestHits[s];
+        const FVector Direction = (Ends[s] - Start).GetSafeNormal();
+        FHitResult& OutHit = OutHits[s];
+        OutHit =
+            FHitResult(HitComponent->GetCharacter(), HitComponent->GetCharacter()->GetMesh(), ClosestHit.ImpactPoint, -Direction);
+        OutHit.TraceStart = Start;
+        OutHit.TraceEnd = Ends[s];
+        OutHit.Distance = ClosestHit.Distance;
+        OutHit.Time = ClosestHit.Distance / FMath::Max(FVector::Dist(Start, Ends[s]), KINDA_SMALL_NUMBER);
+        OutHit.ImpactPoint = ClosestHit.ImpactPoint;
+        OutHit.bBlockingHit = true;
+        OutHit.Item = ClosestHit.HitboxIndex;
+        ++NumHits;
+    }
+    return NumHits;
+}
@@ -0,0 +1,256 @@
+// Copyright (c) 2024 Rasna Studios. All rights reserved.
+
+#include "Subsystems/NetProfilerSubsystem.h"
+
+#include "Engine/NetConnection.h"
+#include "Engine/NetDriver.h"
+#include "Engine/PackageMapClient.h"
+#include "GameFramework/PlayerController.h"
+#include "GameFramework/PlayerState.h"
+#include "HAL/FileManager.h"
+#include "Misc/DateTime.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+
+static TAutoConsoleVariable<int32> CVarNetProfile(TEXT("OpenShooter.Net.Profile"), 0,
+    TEXT("Records the bandwidth per actor class, RPC and property (see OpenShooter.Net.Profile.Print)"), ECVF_Default);
+
+static TAutoConsoleVariable<int32> CVarNetProfileOverlay(TEXT("OpenShooter.Net.Profile.Overlay"), 0,
+    TEXT("Number of bandwidth profiler lines drawn on the HUD, 0 to hide the overlay"), ECVF_Default);
+
+static FAutoConsoleCommandWithWorldAndArgs GNetProfilePrintCommand(TEXT("OpenShooter.Net.Profile.Print"),
+    TEXT("Prints the bandwidth per actor class, RPC and property. The optional argument filters the names and connections"),
+    FConsoleCommandWithWorldAndArgsDelegate::CreateLambda(
+        [](const TArray<FString>& Args, const UWorld* World)
+        {
+            if (const UNetProfilerSubsystem* Profiler = World ? World->GetSubsystem<UNetProfilerSubsystem>() : nullptr)
+                Profiler->LogReport(Args.Num() > 0 ? Args[0] : FString());
+        }));
+
+static FAutoConsoleCommandWithWorld GNetProfileCsvCommand(TEXT("OpenShooter.Net.Profile.Csv"),
+    TEXT("Writes the bandwidth profiler report to Saved/Profiling/NetProfile"),
+    FConsoleCommandWithWorldDelegate::CreateLambda(
+        [](const UWorld* World)
+        {
+            if (const UNetProfilerSubsystem* Profiler = World ? World->GetSubsystem<UNetProfilerSubsystem>() : nullptr)
+            {
+                const FString Path = Profiler->WriteCsv();
+                UE_LOG(LogTemp, Log, TEXT("Net profile %s %s"), Path.IsEmpty() ? TEXT("not written") : TEXT("written to"), *Path);
+            }
+        }));
+
+static FAutoConsoleCommandWithWorld GNetProfileResetCommand(TEXT("OpenShooter.Net.Profile.Reset"),
+    TEXT("Clears the bandwidth profiler"),
+    FConsoleCommandWithWorldDelegate::CreateLambda(
+        [](UWorld* World)
+        {
+            if (UNetProfilerSubsystem* Profiler = World ? World->GetSubsystem<UNetProfilerSubsystem>() : nullptr)
+                Profiler->Reset();
+        }));
+
+bool UNetProfilerSubsystem::IsEnabled()
+{
+    return CVarNetProfile.GetValueOnGameThread() != 0;
+}
+
+int32 UNetProfilerSubsystem::GetOverlayLines()
+{
+    return IsEnabled() ? FMath::Max(CVarNetProfileOverlay.GetValueOnGameThread(), 0) : 0;
+}
+
+UNetProfilerSubsystem* UNetProfilerSubsystem::Get(const UNetConnection* Connection)
+{
+    if (!IsEnabled() || Connection == nullptr)
+        return nullptr;
+    const UWorld* World = Connection->GetWorld();
+    return World ? World->GetSubsystem<UNetProfilerSubsystem>() : nullptr;
+}
+
+void UNetProfilerSubsystem::Record(
+    const ENetProfileCategory Category, const FName Name, UNetConnection* Connection, const bool bSent, const int64 Bits)
+{
+    const FKey Key{Category, Name, Connection, bSent};
+    FEntry* Entry = Entries.Find(Key);
+    if (Entry == nullptr)
+    {
+        Entry = &Entries.Add(Key);
+        Entry->Connection = GetConnectionName(Connection);
+    }
+
+    const int64 Second = GetSecond();
+    Entry->Advance(Second);
+    const int32 Bucket = Second % WindowSeconds;
+    Entry->Bits[Bucket] += Bits;
+    Entry->Counts[Bucket]++;
+}
+
+void UNetProfilerSubsystem::FEntry::Advance(const int64 Second)
+{
+    const int64 Elapsed = FMath::Min<int64>(Second - LastSecond, WindowSeconds);
+    for (int64 i = 1; i <= Elapsed; ++i)
+    {
+        const int32 Bucket = (LastSecond + i) % WindowSeconds;
+        Bits[Bucket] = 0;
+        Counts[Bucket] = 0;
+    }
+    LastSecond = FMath::Max(LastSecond, Second);
+}
+
+void UNetProfilerSubsystem::GetRows(TArray<FNetProfileRow>& OutRows, const FString& Filter) const
+{
+    OutRows.Reset();
+
+    // The windows end at the last complete second. A bucket is only valid if it was not overwritten since
+    const int64 Now = GetSecond();
+    for (const TPair<FKey, FEntry>& Pair : Entries)
+    {
+        const FEntry& Entry = Pair.Value;
+        UNetConnection* Connection = Pair.Key.Connection.ResolveObjectPtr();
+
+        FNetProfileRow Row;
+        Row.Category = Pair.Key.Category;
+        Row.Name = Pair.Key.Name;
+        Row.Connection = Connection ? GetConnectionName(Connection) : Entry.Connection;    // the player name may come later
+        Row.bSent = Pair.Key.bSent;
+
+        int64 Bits1s = 0, Bits60s = 0;
+        for (int64 Second = Now - WindowSeconds; Second < Now; ++Second)
+        {
+            if (Second <= Entry.LastSecond - WindowSeconds || Second > Entry.LastSecond)
+                continue;
+            const int32 Bucket = Second % WindowSeconds;
+            Bits60s += Entry.Bits[Bucket];
+            Row.Count60s += Entry.Counts[Bucket];
+            if (Second == Now - 1)
+            {
+                Bits1s = Entry.Bits[Bucket];
+                Row.Count1s = Entry.Counts[Bucket];
+            }
+        }
+        if (Row.Count60s == 0)
+            continue;
+        if (!Filter.IsEmpty() && !Row.Name.ToString().Contains(Filter) && !Row.Connection.Contains(Filter))
+            continue;
+
+        Row.Bytes1s = (Bits1s + 7) / 8;
+        Row.Bytes60s = (Bits60s + 7) / 8;
+        OutRows.Add(MoveTemp(Row));
+    }
+
+    OutRows.Sort(
+        [](const FNetProfileRow& A, const FNetProfileRow& B)
+        { return A.Bytes1s != B.Bytes1s ? A.Bytes1s > B.Bytes1s : A.Bytes60s > B.Bytes60s; });
+}
+
+void UNetProfilerSubsystem::LogReport(const FString& Filter) const
+{
+    TArray<FNetProfileRow> Rows;
+    GetRows(Rows, Filter);
+
+    UE_LOG(LogTemp, Log, TEXT("Net profile (%d lines): bytes/s and count over the last second, then averaged over %d seconds"),
+        Rows.Num(), WindowSeconds);
+    for (const FNetProfileRow& Row : Rows)
+    {
+        UE_LOG(LogTemp, Log, TEXT("  %-8s %-4s %-48s %-24s %8lld B/s %5d/s | %10.1f B/s %7.1f/s"),
+            *UEnum::GetDisplayValueAsText(Row.Category).ToString(), Row.bSent ? TEXT("Out") : TEXT("In"), *Row.Name.ToString(),
+            *Row.Connection, Row.Bytes1s, Row.Count1s, static_cast<double>(Row.Bytes60s) / WindowSeconds,
+            static_cast<double>(Row.Count60s) / WindowSeconds);
+    }
+}
+
+FString UNetProfilerSubsystem::WriteCsv() const
+{
+    TArray<FNetProfileRow> Rows;
+    GetRows(Rows);
+
+    FString Csv = TEXT("Category,Direction,Name,Connection,Bytes1s,Count1s,Bytes60s,Count60s\n");
+    for (const FNetProfileRow& Row : Rows)
+    {
+        Csv += FString::Printf(TEXT("%s,%s,%s,\"%s\",%lld,%d,%lld,%d\n"),
+            *UEnum::GetDisplayValueAsText(Row.Category).ToString(), Row.bSent ? TEXT("Out") : TEXT("In"), *Row.Name.ToString(),
+            *Row.Connection.Replace(TEXT("\""), TEXT("'")), Row.Bytes1s, Row.Count1s, Row.Bytes60s, Row.Count60s);
+    }
+
+    const TCHAR* Side = GetWorld()->IsNetMode(NM_Client) ? TEXT("Client") : TEXT("Server");
+    const FString FileName = FString::Printf(TEXT("NetProfile-%s-%s.csv"), Side, *FDateTime::Now().ToString());
+    const FString Path = FPaths::ProfilingDir() / TEXT("NetProfile") / FileName;
+    return FFileHelper::SaveStringToFile(Csv, *Path) ? IFileManager::Get().ConvertToAbsolutePathForExternalAppForWrite(*Path)
+                                                       : FString();
+}
+
+void UNetProfilerSubsystem::Reset()
+{
+    Entries.Reset();
+}
+
+int64 UNetProfilerSubsystem::GetSecond()
+{
+    return static_cast<int64>(FPlatformTime::Seconds());
+}
+
+FString UNetProfilerSubsystem::GetConnectionName(UNetConnection* Connection)
+{
+    if (Connection == nullptr)
+        return TEXT("Queued");
+    if (Connection->Driver && Connection->Driver->ServerConnection == Connection)
+        return TEXT("Server");
+    if (Connection->PlayerController && Connection->PlayerController->PlayerState)
+        return Connection->PlayerController->PlayerState->GetPlayerName();
+    return Connection->LowLevelGetRemoteAddress(true);
+}
+
+// = RPC scope =
+
+FName FNetProfileRPCScope::Current;
+bool FNetProfileRPCScope::bSent = false;
+
+FNetProfileRPCScope::FNetProfileRPCScope(const UObject* InObject, const UFunction* InFunction)
+{
+    if (!UNetProfilerSubsystem::IsEnabled() || InFunction == nullptr)
+        return;
+
+    Object = InObject;
+    Function = InFunction;
+    Previous = Current;
+    bPreviousSent = bSent;
+    Current = Function->GetFName();
+    bSent = false;
+}
+
+FNetProfileRPCScope::~FNetProfileRPCScope()
+{
+    if (Function == nullptr)
+        return;
+
+    // Nothing went out: the engine queued it (unreliable multicast), or it ran locally. Count the queued call anyway
+    if (!bSent && Function->HasAnyFunctionFlags(FUNC_NetMulticast) && Object)
+    {
+        const UWorld* World = Object->GetWorld();
+        UNetProfilerSubsystem* Profiler = World ? World->GetSubsystem<UNetProfilerSubsystem>() : nullptr;
+        if (Profiler && World->GetNetMode() != NM_Standalone && World->GetNetMode() != NM_Client)
+            Profiler->Record(ENetProfileCategory::ENPC_RPC, Current, nullptr, true, 0);
+    }
+
+    Current = Previous;
+    bSent = bPreviousSent;
+}
+
+// = Property scope =
+
+FNetProfilePropertyScope::FNetProfilePropertyScope(const TCHAR* InName, FArchive& Ar, UPackageMap* Map)
+    : Name(InName), bSent(Ar.IsSaving())
+{
+    // The copy being sized goes through the same NetSerialize
+    if (!UNetProfilerSubsystem::IsEnabled() || !Ar.IsNetArchive() || FNetBitCounter::IsCounting())
+        return;
+
+    UPackageMapClient* PackageMap = Cast<UPackageMapClient>(Map);
+    Connection = PackageMap ? PackageMap->GetConnection() : nullptr;
+    Profiler = UNetProfilerSubsystem::Get(Connection);
+}
+
+FNetProfilePropertyScope::~FNetProfilePropertyScope()
+{
+    if (Profiler && CountBits)
+        Profiler->Record(ENetProfileCategory::ENPC_Property, FName(Name), Connection, bSent, CountBits(Value));
+}
@@ -0,0 +1,120 @@
+// Copyright (c) 2024 Rasna Studios. All rights reserved.
+
+#include "Subsystems/ProjectilePoolSubsystem.h"
+
+#include "OpenShooter.h"
+#include "Weapon/Projectile.h"
+
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Projectile Pool Hits"), STAT_ProjectilePoolHits, STATGROUP_OpenShooter);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Projectile Pool Misses"), STAT_ProjectilePoolMisses, STATGROUP_OpenShooter);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Projectiles In Flight"), STAT_ProjectilesInFlight, STATGROUP_OpenShooter);
+
+static FAutoConsoleCommandWithWorld GProjectilePoolStatsCommand(TEXT("OpenShooter.ProjectilePool.Stats"),
+    TEXT("Prints the projectile pool hit/miss counters for every projectile class"),
+    FConsoleCommandWithWorldDelegate::CreateLambda(
+        [](const UWorld* World)
+        {
+            if (const UProjectilePoolSubsystem* Pool = World ? World->GetSubsystem<UProjectilePoolSubsystem>() : nullptr)
+                Pool->LogStats();
+        }));
+
+void UProjectilePoolSubsystem::Prewarm(const TSubclassOf<AProjectile> ProjectileClass, const int32 Count)
+{
+    if (ProjectileClass == nullptr)
+        return;
+
+    FProjectilePool& Pool = Pools.FindOrAdd(ProjectileClass);
+    while (Pool.Free.Num() < FMath::Min(Count, MaxPooledPerClass))
+    {
+        AProjectile* Projectile = SpawnPooledProjectile(ProjectileClass);
+        if (Projectile == nullptr)
+            return;
+        Pool.Free.Add(Projectile);
+        Pool.Stats.Prewarmed++;
+    }
+}
+
+AProjectile* UProjectilePoolSubsystem::Acquire(
+    const TSubclassOf<AProjectile> ProjectileClass, const FTransform& SpawnTransform, AActor* Owner, APawn* Instigator)
+{
+    if (ProjectileClass == nullptr)
+        return nullptr;
+
+    FProjectilePool& Pool = Pools.FindOrAdd(ProjectileClass);
+
+    AProjectile* Projectile = nullptr;
+    while (!IsValid(Projectile) && Pool.Free.Num() > 0)
+        Projectile = Pool.Free.Pop(EAllowShrinking::No);    // skip the ones destroyed by someone else (e.g. level streaming)
+
+    if (IsValid(Projectile))
+    {
+        Pool.Stats.Hits++;
+        INC_DWORD_STAT(STAT_ProjectilePoolHits);
+    }
+    else
+    {
+        Projectile = SpawnPooledProjectile(ProjectileClass);
+        if (Projectile == nullptr)
+            return nullptr;
+        Pool.Stats.Misses++;
+        INC_DWORD_STAT(STAT_ProjectilePoolMisses);
+    }
+
+    Projectile->SetOwner(Owner);
+    Projectile->SetInstigator(Instigator);
+    Projectile->Launch(SpawnTransform);
+
+    Pool.Stats.InFlight++;
+    INC_DWORD_STAT(STAT_ProjectilesInFlight);
+    return Projectile;
+}
+
+void UProjectilePoolSubsystem::Release(AProjectile* Projectile)
+{
+    if (!IsValid(Projectile) || !Projectile->IsActive())
+        return;    // already in the pool
+
+    FProjectilePool& Pool = Pools.FindOrAdd(Projectile->GetClass());
+    Pool.Stats.InFlight = FMath::Max(Pool.Stats.InFlight - 1, 0);
+    DEC_DWORD_STAT(STAT_ProjectilesInFlight);
+
+    if (Pool.Free.Num() >= MaxPooledPerClass)
+    {
+        Pool.Stats.Destroyed++;
+        Projectile->Destroy();
+        return;
+    }
+
+    Projectile->Retire();
+    Projectile->SetOwner(nullptr);
+    Pool.Free.Add(Projectile);
+}
+
+AProjectile* UProjectilePoolSubsystem::SpawnPooledProjectile(const TSubclassOf<AProjectile> ProjectileClass) const
+{
+    UWorld* World = GetWorld();
+    if (World == nullptr)
+        return nullptr;
+
+    FActorSpawnParameters SpawnParams;
+    SpawnParams.SpawnCollisionHandlingOverride = ESpawnActorCollisionHandlingMethod::AlwaysSpawn;
+
+    // The projectile stays retired (hidden and dormant) until the pool launches it
+    AProjectile* Projectile = World->SpawnActor<AProjectile>(ProjectileClass, FTransform::Identity, SpawnParams);
+    if (Projectile)
+        Projectile->Retire();
+    return Projectile;
+}
+
+void UProjectilePoolSubsystem::LogStats() const
+{
+    for (const TPair<TSubclassOf<AProjectile>, FProjectilePool>& Pair : Pools)
+    {
+        const FProjectilePoolStats& Stats = Pair.Value.Stats;
+        const int32 Acquires = Stats.Hits + Stats.Misses;
+        UE_LOG(LogTemp, Log,
+            TEXT("%s: %d acquires, %d hits (%.1f%%), %d misses, %d prewarmed, %d in flight, %d free, %d destroyed"),
+            *GetNameSafe(Pair.Key), Acquires, Stats.Hits, Acquires > 0 ? 100.f * Stats.Hits / Acquires : 0.f, Stats.Misses,
+            Stats.Prewarmed, Stats.InFlight, Pair.Value.Free.Num(), Stats.Destroyed);
+    }
+}
@@ -0,0 +1,69 @@
+// Copyright (c) 2024 Rasna Studios. All rights reserved.
+
+#include "Weapon/FireBatch.h"
+
+#include "OpenShooter.h"
+#include "Replication/NetBitCounter.h"
+
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Fire Batch Bytes Sent"), STAT_FireBatchBytes, STATGROUP_OpenShooter);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Fire Batch Shots Sent"), STAT_FireBatchShots, STATGROUP_OpenShooter);
+
+bool FFireBatch::NetSerialize(FArchive& Ar, UPackageMap* Map, bool& bOutSuccess)
+{
+    bOutSuccess = true;
+
+    uint32 NumShots = FMath::Min(Targets.Num(), MaxShots);
+    Ar.SerializeInt(NumShots, MaxShots + 1);
+    if (Ar.IsLoading())
+    {
+        if (NumShots > MaxShots)
+        {
+            bOutSuccess = false;
+            return false;
+        }
+        Targets.SetNum(NumShots);
+        FireTimes.SetNum(NumShots);
+    }
+    if (NumShots == 0)
+        return true;
+    Ar << FirstSequence;
+
+    // Both sides rebuild the values from the quantized deltas, so the error does not accumulate along the batch
+    FVector Previous = FVector::ZeroVector;
+    float PreviousTime = 0.f;
+    for (uint32 i = 0; i < NumShots; ++i)
+    {
+        FVector Delta = FVector::ZeroVector;
+        if (Ar.IsSaving())
+        {
+            const FVector Exact = Targets[i] - Previous;
+            Delta = FVector(FMath::RoundToDouble(Exact.X), FMath::RoundToDouble(Exact.Y), FMath::RoundToDouble(Exact.Z));
+        }
+        bOutSuccess &= SerializePackedVector<1, 24>(Delta, Ar);
+        Previous += Delta;
+        Targets[i] = Previous;
+
+        if (i == 0)
+        {
+            Ar << FireTimes[0];
+            PreviousTime = FireTimes[0];
+            continue;
+        }
+        uint32 DeltaMs = Ar.IsSaving() ? FMath::Max(FMath::RoundToInt((FireTimes[i] - PreviousTime) * 1000.f), 0) : 0;
+        Ar.SerializeIntPacked(DeltaMs);
+        PreviousTime += DeltaMs / 1000.f;
+        FireTimes[i] = PreviousTime;
+    }
+    return true;
+}
+
+void FFireBatch::RecordSent() const
+{
+#if STATS
+    // Sized with a copy: serializing it again costs something, so only while the stats are shown
+    if (!FThreadStats::IsCollectingData())
+        return;
+    INC_DWORD_STAT_BY(STAT_FireBatchBytes, (FNetBitCounter::Count(*this) + 7) / 8);
+    INC_DWORD_STAT_BY(STAT_FireBatchShots, Num());
+#endif
+}
@@ -0,0 +1,146 @@
+// Copyright (c) 2024 Rasna Studios. All rights reserved.
+
+#include "Weapon/HitScanWeapon.h"
+
+#include "GameFramework/Character.h"
+#include "Kismet/GameplayStatics.h"
+#include "Particles/ParticleSystemComponent.h"
+#include "Sound/SoundCue.h"
+#include "Subsystems/LagCompensationSubsystem.h"
+
+void AHitScanWeapon::Fire(const FVector& HitTarget, const float FireTime, const uint16 FireSequence)
+{
+    Super::Fire(HitTarget, FireTime, FireSequence);
+
+    const FVector Start = GetMesh()->GetSocketTransform(FName("MuzzleFlash")).GetLocation();
+
+    // Build all the traces of this shot. Same seed on every machine, so the same pattern everywhere
+    const int32 NumTraces = IsShotgun() ? FMath::Clamp(NumberOfPellets, 1, 32) : 1;
+    FRandomStream Stream = MakeScatterStream(FireSequence);
+    TArray<FVector, TInlineAllocator<32>> Ends;
+    Ends.Reserve(NumTraces);
+    for (int32 i = 0; i < NumTraces; ++i)
+        Ends.Add(UsesScatter() ? TraceEndWithScatter(Start, HitTarget, Stream) : Start + (HitTarget - Start) * 1.25f);
+
+    FHitScanResult Result;
+    if (HasAuthority())
+        ResolveShot(Start, Ends, FireTime, Result);
+    else
+        TraceCosmetic(Start, Ends, Result);
+
+    if (GetNetMode() != NM_DedicatedServer)
+        PlayHitScanEffects(Start, Result);
+}
+
+void AHitScanWeapon::ResolveShot(
+    const FVector& Start, TArrayView<FVector> Ends, const float FireTime, FHitScanResult& OutResult) const
+{
+    UWorld* World = GetWorld();
+    ULagCompensationSubsystem* LagCompensation = World ? World->GetSubsystem<ULagCompensationSubsystem>() : nullptr;
+    if (LagCompensation == nullptr)
+        return;
+    const int32 NumTraces = Ends.Num();
+
+    // World first: the characters' collision is ignored, they are tested against their rewound hitboxes below.
+    // Every pellet that hits the world is shortened so it can't hit a character behind a wall
+    FCollisionObjectQueryParams WorldObjects;
+    WorldObjects.AddObjectTypesToQuery(ECC_WorldStatic);
+    WorldObjects.AddObjectTypesToQuery(ECC_WorldDynamic);
+    FCollisionQueryParams QueryParams(SCENE_QUERY_STAT(HitScanWeapon), true, GetOwner());
+    QueryParams.AddIgnoredActor(this);
+
+    OutResult.ImpactPoints.SetNum(NumTraces);
+    for (int32 i = 0; i < NumTraces; ++i)
+    {
+        FHitResult WorldHit;
+        if (World->LineTraceSingleByObjectType(WorldHit, Start, Ends[i], WorldObjects, QueryParams))
+        {
+            Ends[i] = WorldHit.ImpactPoint;
+            OutResult.BlockingHitMask |= 1u << i;
+        }
+        OutResult.ImpactPoints[i] = Ends[i];
+    }
+
+    // The characters along the pellets record their real pose every frame from now on, for the next shots of the burst. This
+    // shot is tested against the periodic samples (see ULagCompensationComponent)
+    for (const FVector& End : Ends)
+        LagCompensation->RequestPoseSamples(Start, End, 0.f);
+
+    // Then all the pellets against the characters, as the shooter was seeing them
+    TArray<FHitResult> CharacterHits;
+    const float RewindTime = LagCompensation->ClampRewindTime(FireTime);
+    LagCompensation->TraceRewoundBatch(Start, Ends, RewindTime, GetOwner(), CharacterHits);
+
+    // Sum the damage per character, so a shotgun blast is a single damage event per victim
+    TMap<AActor*, float, TInlineSetAllocator<8>> DamagePerActor;
+    for (int32 i = 0; i < NumTraces; ++i)
+    {
+        const FHitResult& Hit = CharacterHits[i];
+        if (!Hit.bBlockingHit)
+            continue;
+        OutResult.ImpactPoints[i] = Hit.ImpactPoint;
+        OutResult.BlockingHitMask |= 1u << i;
+        OutResult.CharacterHitMask |= 1u << i;
+        DamagePerActor.FindOrAdd(Hit.GetActor()) += Damage;
+    }
+
+    if (const ACharacter* OwnerCharacter = Cast<ACharacter>(GetOwner()))
+        if (AController* OwnerController = OwnerCharacter->GetController())
+            for (const TPair<AActor*, float>& Pair : DamagePerActor)
+                UGameplayStatics::ApplyDamage(Pair.Key, Pair.Value, OwnerController, this, UDamageType::StaticClass());
+}
+
+void AHitScanWeapon::TraceCosmetic(const FVector& Start, TArrayView<const FVector> Ends, FHitScanResult& OutResult) const
+{
+    FCollisionQueryParams QueryParams(SCENE_QUERY_STAT(HitScanWeaponCosmetic), false, GetOwner());
+    QueryParams.AddIgnoredActor(this);
+
+    OutResult.ImpactPoints.SetNum(Ends.Num());
+    for (int32 i = 0; i < Ends.Num(); ++i)
+    {
+        FHitResult Hit;
+        if (GetWorld()->LineTraceSingleByChannel(Hit, Start, Ends[i], ECC_Visibility, QueryParams))
+        {
+            OutResult.ImpactPoints[i] = Hit.ImpactPoint;
+            OutResult.BlockingHitMask |= 1u << i;
+            if (Hit.GetActor() && Hit.GetActor()->IsA<ACharacter>())
+                OutResult.CharacterHitMask |= 1u << i;
+        }
+        else
+        {
+            OutResult.ImpactPoints[i] = Ends[i];
+        }
+    }
+}
+
+void AHitScanWeapon::PlayHitScanEffects(const FVector& TraceStart, const FHitScanResult& Result) const
+{
+    // One sound per kind of impact per shot, otherwise a shotgun blast plays the same sound ten times on top of each other
+    bool bPlayedImpactSound = false;
+    bool bPlayedCharacterSound = false;
+
+    for (int32 i = 0; i < Result.ImpactPoints.Num(); ++i)
+    {
+        const FVector ImpactPoint = Result.ImpactPoints[i];
+        if (BeamParticles)
+        {
+            if (UParticleSystemComponent* Beam = UGameplayStatics::SpawnEmitterAtLocation(GetWorld(), BeamParticles, TraceStart))
+                Beam->SetVectorParameter(FName("Target"), ImpactPoint);
+        }
+
+        if ((Result.BlockingHitMask & (1u << i)) == 0)
+            continue;
+
+        const bool bHitCharacter = (Result.CharacterHitMask & (1u << i)) != 0;
+        UParticleSystem* Particles = bHitCharacter ? CharacterImpactParticles : ImpactParticles;
+        if (Particles)
+            UGameplayStatics::SpawnEmitterAtLocation(GetWorld(), Particles, ImpactPoint);
+
+        bool& bPlayedSound = bHitCharacter ? bPlayedCharacterSound : bPlayedImpactSound;
+        if (USoundCue* Sound = bHitCharacter ? CharacterImpactSound : ImpactSound; Sound && !bPlayedSound)
+        {
+            UGameplayStatics::PlaySoundAtLocation(this, Sound, ImpactPoint);
+            bPlayedSound = true;
+        }
+    }
+}
@@ -0,0 +1,112 @@
+// Copyright (c) 2024 Rasna Studios. All rights reserved.
+
+#include "Weapon/ImpactBatch.h"
+
+#include "OpenShooter.h"
+#include "Replication/NetBitCounter.h"
+
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Impact Batch Bytes Sent"), STAT_ImpactBatchBytes, STATGROUP_OpenShooter);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Impacts Sent"), STAT_ImpactsSent, STATGROUP_OpenShooter);
+
+bool FImpactBatch::Add(
+    const FVector& Location, const FRotator& Rotation, const uint8 SurfaceType, const bool bVictim, UClass* Source)
+{
+    if (Impacts.Num() >= MaxImpacts)
+        return false;
+
+    int32 SourceIndex = Sources.Find(Source);
+    if (SourceIndex == INDEX_NONE)
+    {
+        if (Sources.Num() >= MaxSources)
+            return false;
+        SourceIndex = Sources.Add(Source);
+    }
+
+    FImpactEvent& Impact = Impacts.AddDefaulted_GetRef();
+    Impact.Location = Location;
+    Impact.Rotation = Rotation;
+    Impact.SurfaceType = SurfaceType;
+    Impact.bVictim = bVictim;
+    Impact.SourceIndex = static_cast<uint8>(SourceIndex);
+    return true;
+}
+
+bool FImpactBatch::NetSerialize(FArchive& Ar, UPackageMap* Map, bool& bOutSuccess)
+{
+    bOutSuccess = true;
+
+    uint32 NumSources = FMath::Min(Sources.Num(), MaxSources);
+    uint32 NumImpacts = FMath::Min(Impacts.Num(), MaxImpacts);
+    Ar.SerializeInt(NumSources, MaxSources + 1);
+    Ar.SerializeInt(NumImpacts, MaxImpacts + 1);
+    if (Ar.IsLoading())
+    {
+        if (NumSources > MaxSources || NumImpacts > MaxImpacts)
+        {
+            bOutSuccess = false;
+            return false;
+        }
+        Sources.SetNum(NumSources);
+        Impacts.SetNum(NumImpacts);
+    }
+
+    for (uint32 i = 0; i < NumSources; ++i)
+    {
+        UObject* Source = Sources[i];
+        Map->SerializeObject(Ar, UClass::StaticClass(), Source);
+        if (Ar.IsLoading())
+            Sources[i] = Cast<UClass>(Source);
+    }
+
+    FVector Previous = FVector::ZeroVector;
+    for (uint32 i = 0; i < NumImpacts; ++i)
+    {
+        FImpactEvent& Impact = Impacts[i];
+
+        // Both sides rebuild the locations from the rounded deltas, so the error does not accumulate along the batch
+        FVector Delta = FVector::ZeroVector;
+        if (Ar.IsSaving())
+        {
+            const FVector Exact = Impact.Location - Previous;
+            Delta = FVector(FMath::RoundToDouble(Exact.X), FMath::RoundToDouble(Exact.Y), FMath::RoundToDouble(Exact.Z));
+        }
+        bOutSuccess &= SerializePackedVector<1, 24>(Delta, Ar);
+        Previous += Delta;
+        Impact.Location = Previous;
+
+        // [0-5] surface type, [6] victim, [7-9] source
+        uint32 Packed = 0;
+        if (Ar.IsSaving())
+            Packed = (Impact.SurfaceType & 63) | (Impact.bVictim ? 1u : 0u) << 6 | (Impact.SourceIndex & 7) << 7;
+        Ar.SerializeBits(&Packed, 10);
+
+        uint8 Pitch = FRotator::CompressAxisToByte(Impact.Rotation.Pitch);
+        uint8 Yaw = FRotator::CompressAxisToByte(Impact.Rotation.Yaw);
+        Ar << Pitch << Yaw;
+
+        if (Ar.IsLoading())
+        {
+            Impact.SurfaceType = static_cast<uint8>(Packed & 63);
+            Impact.bVictim = (Packed >> 6 & 1) != 0;
+            Impact.SourceIndex = static_cast<uint8>(Packed >> 7 & 7);
+            Impact.Rotation = FRotator(FRotator::DecompressAxisFromByte(Pitch), FRotator::DecompressAxisFromByte(Yaw), 0.f);
+            if (Impact.SourceIndex >= NumSources)
+            {
+                bOutSuccess = false;
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+void FImpactBatch::RecordSent() const
+{
+#if STATS
+    // Sized with a copy, like the fire batches: only while the stats are shown
+    if (!FThreadStats::IsCollectingData())
+        return;
+    INC_DWORD_STAT_BY(STAT_ImpactBatchBytes, (FNetBitCounter::Count(*this) + 7) / 8);
+    INC_DWORD_STAT_BY(STAT_ImpactsSent, Num());
+#endif
+}
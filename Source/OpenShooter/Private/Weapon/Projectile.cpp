@@ -6,8 +6,13 @@
 #include "Components/BoxComponent.h"
 #include "GameFramework/ProjectileMovementComponent.h"
 #include "Kismet/GameplayStatics.h"
+#include "Net/Core/PushModel/PushModel.h"
+#include "Net/UnrealNetwork.h"
 #include "OpenShooter.h"
+#include "Particles/ParticleSystemComponent.h"
 #include "Sound/SoundCue.h"
+#include "Subsystems/ImpactEventSubsystem.h"
+#include "Subsystems/ProjectilePoolSubsystem.h"
 
 AProjectile::AProjectile()
 {
@@ -24,11 +29,32 @@ AProjectile::AProjectile()
     CollisionBox->SetCollisionResponseToChannel(ECC_Visibility, ECR_Block);     // but block visibility channel
     CollisionBox->SetCollisionResponseToChannel(ECC_WorldStatic, ECR_Block);    // and block world static channel
     CollisionBox->SetCollisionResponseToChannel(ECC_SkeletalMesh, ECollisionResponse::ECR_Block);    // and block pawn channel
+    CollisionBox->bReturnMaterialOnMove = true;    // the surface type of the hits picks the impact effects
 
     ProjectileMovement = CreateDefaultSubobject<UProjectileMovementComponent>(TEXT("ProjectileMovement"));
     ProjectileMovement->bRotationFollowsVelocity = true;
     ProjectileMovement->MaxSpeed = 15000.f;
     ProjectileMovement->InitialSpeed = 15000.f;
+    ProjectileMovement->bAutoActivate = false;    // the projectile moves only once launched
+}
+
+void AProjectile::PostInitProperties()
+{
+    // Before the actor sets its remote role from bReplicates
+    if (bClientSimulated)
+        bReplicates = false;
+
+    Super::PostInitProperties();
+}
+
+void AProjectile::GetLifetimeReplicatedProps(TArray<FLifetimeProperty>& OutLifetimeProps) const
+{
+    Super::GetLifetimeReplicatedProps(OutLifetimeProps);
+
+    // Push based: the net driver only compares it after a launch or a retirement
+    FDoRepLifetimeParams Params;
+    Params.bIsPushBased = true;
+    DOREPLIFETIME_WITH_PARAMS_FAST(AProjectile, LaunchState, Params);
 }
 
 void AProjectile::BeginPlay()
@@ -38,6 +64,7 @@ void AProjectile::BeginPlay()
     // To see where the projectile is spawned. It should spawn at the muzzle of the gun, not at the center
     // DrawDebugSphere(GetWorld(), GetActorLocation(), 10.f, 12, FColor::Red, true, 5.f, 0, 1.f);
 
+    // The tracer is created once and reset at every launch
     if (Tracer)
     {
         TracerComponent =
@@ -45,35 +72,188 @@ void AProjectile::BeginPlay()
                 EAttachLocation::KeepWorldPosition,    // this will follow along with the collision box
                 false);
     }
-    if (HasAuthority())
+    if (IsAuthoritative())
     {    // only the server should handle the hit events
         CollisionBox->OnComponentHit.AddDynamic(this, &AProjectile::OnHit);
     }
+    else if (IsCosmetic())
+    {
+        CollisionBox->OnComponentHit.AddDynamic(this, &AProjectile::OnCosmeticHit);
+    }
+
+    // A client can receive the projectile already in flight
+    if (LaunchState.bActive)
+        LaunchLocal();
+    else
+        RetireLocal();
+}
+
+void AProjectile::Launch(const FTransform& SpawnTransform)
+{
+    GetWorldTimerManager().ClearTimer(RecycleTimer);
+
+    LaunchState.Location = SpawnTransform.GetLocation();
+    LaunchState.Direction = SpawnTransform.GetRotation().GetForwardVector();
+    LaunchState.LaunchId++;
+    LaunchState.bActive = true;    // triggers OnRep_LaunchState
+
+    // Pooled projectiles sleep while in the pool. A client simulated projectile is not replicated, there is nothing to send
+    if (GetIsReplicated())
+    {
+        MARK_PROPERTY_DIRTY_FROM_NAME(AProjectile, LaunchState, this);
+        SetNetDormancy(DORM_Awake);
+        ForceNetUpdate();
+    }
+
+    LaunchLocal();
+
+    GetWorldTimerManager().SetTimer(RecycleTimer, this, &AProjectile::Recycle, MaxLifetime);
+}
+
+void AProjectile::Retire()
+{
+    GetWorldTimerManager().ClearTimer(RecycleTimer);
+
+    LaunchState.bActive = false;    // triggers OnRep_LaunchState
+    RetireLocal();
+
+    // Send the retired state, then stop considering the projectile for replication until the next launch
+    if (GetIsReplicated())
+    {
+        MARK_PROPERTY_DIRTY_FROM_NAME(AProjectile, LaunchState, this);
+        ForceNetUpdate();
+        SetNetDormancy(DORM_DormantAll);
+    }
+}
+
+void AProjectile::OnRep_LaunchState()
+{
+    if (LaunchState.bActive)
+        LaunchLocal();
+    else
+        RetireLocal();
+}
+
+void AProjectile::LaunchLocal()
+{
+    SetActorLocationAndRotation(
+        LaunchState.Location, LaunchState.Direction.Rotation(), false, nullptr, ETeleportType::TeleportPhysics);
+    SetActorHiddenInGame(false);
+    SetActorEnableCollision(true);
+    SetActorTickEnabled(true);
+
+    // The movement component clears its updated component when it stops, so we set it again before moving
+    ProjectileMovement->SetUpdatedComponent(CollisionBox);
+    ProjectileMovement->Velocity = FVector(LaunchState.Direction) * ProjectileMovement->InitialSpeed;
+    ProjectileMovement->UpdateComponentVelocity();
+    ProjectileMovement->Activate(true);
+
+    if (TracerComponent)
+        TracerComponent->ActivateSystem(true);    // reset, so the trail does not stretch from the last position
+
+    OnLaunched();
+}
+
+void AProjectile::RetireLocal()
+{
+    ProjectileMovement->StopMovementImmediately();
+    ProjectileMovement->Deactivate();
+    SetActorEnableCollision(false);
+    SetActorHiddenInGame(true);
+    SetActorTickEnabled(false);    // nothing to do while sitting in the pool
+
+    if (TracerComponent)
+        TracerComponent->DeactivateImmediate();
+}
+
+void AProjectile::OnLaunched()
+{
+}
+
+void AProjectile::Recycle()
+{
+    if (UProjectilePoolSubsystem* Pool = GetWorld()->GetSubsystem<UProjectilePoolSubsystem>())
+        Pool->Release(this);
+    else
+        Destroy();
+}
+
+float AProjectile::GetFlightTime(const float Distance) const
+{
+    return FMath::Min(Distance / FMath::Max(ProjectileMovement->InitialSpeed, 1.f), MaxLifetime);
+}
+
+void AProjectile::FastForward(float Time)
+{
+    Time = FMath::Min(Time, MaxFastForwardTime);
+    if (Time <= 0.f)
+        return;
+
+    // The movement does not sweep a teleport, so we trace the part of the flight we skip
+    const FVector Start = GetActorLocation();
+    const FVector End = Start + ProjectileMovement->Velocity * Time;
+    FCollisionQueryParams Params(SCENE_QUERY_STAT(ProjectileFastForward), false, this);
+    Params.AddIgnoredActor(GetOwner());
+    FHitResult Hit;
+    if (GetWorld()->LineTraceSingleByChannel(Hit, Start, End, ECC_Visibility, Params))
+    {
+        SetActorLocation(Hit.ImpactPoint, false, nullptr, ETeleportType::TeleportPhysics);
+        OnCosmeticHit(CollisionBox, Hit.GetActor(), Hit.GetComponent(), FVector::ZeroVector, Hit);
+        return;
+    }
+    SetActorLocation(End, false, nullptr, ETeleportType::TeleportPhysics);
 }
 
-void AProjectile::MulticastSpawnEnvironmentHitParticles_Implementation()
+void AProjectile::OnCosmeticHit(UPrimitiveComponent* HitComponent, AActor* OtherActor, UPrimitiveComponent* OtherComponent,
+    FVector NormalImpulse, const FHitResult& Hit)
 {
-    if (ImpactParticles)
-        UGameplayStatics::SpawnEmitterAtLocation(GetWorld(), ImpactParticles, GetActorTransform());
+    // The server confirms the character hits (see UImpactEventSubsystem), we only play the environment ones
+    if (!Cast<AOpenShooterCharacter>(OtherActor))
+        PlayImpactEffects(GetWorld(), GetActorLocation(), GetActorRotation(), UGameplayStatics::GetSurfaceType(Hit));
+    StopAfterHit();
+}
+
+void AProjectile::PlayImpactEffects(
+    UWorld* World, const FVector& Location, const FRotator& Rotation, const EPhysicalSurface SurfaceType) const
+{
+    const TObjectPtr<UParticleSystem>* SurfaceParticles = SurfaceImpactParticles.Find(SurfaceType);
+    if (UParticleSystem* Particles = SurfaceParticles ? SurfaceParticles->Get() : ImpactParticles.Get())
+        UGameplayStatics::SpawnEmitterAtLocation(World, Particles, Location, Rotation);
     if (ImpactSound)
-        UGameplayStatics::PlaySoundAtLocation(GetWorld(), ImpactSound, GetActorLocation());
+        UGameplayStatics::PlaySoundAtLocation(World, ImpactSound, Location);
 }
 
 void AProjectile::OnHit(UPrimitiveComponent* HitComponent, AActor* OtherActor, UPrimitiveComponent* OtherComponent,
     FVector NormalImpulse, const FHitResult& Hit)
 {
+    // The impacts are sent to the clients at the end of the frame, all in one RPC per connection
+    UImpactEventSubsystem* Impacts = GetWorld()->GetSubsystem<UImpactEventSubsystem>();
+    const EPhysicalSurface SurfaceType = UGameplayStatics::GetSurfaceType(Hit);
     if (AOpenShooterCharacter* Character = Cast<AOpenShooterCharacter>(OtherActor))
     {
-        Character->MulticastPlayImpactEffects(Hit.ImpactPoint);
+        if (Impacts)
+            Impacts->AddImpact(Hit.ImpactPoint, GetActorRotation(), SurfaceType, true, Character->GetClass());
     }
-    else
+    else if (GetIsReplicated())
+    {
+        if (Impacts)
+            Impacts->AddImpact(GetActorLocation(), GetActorRotation(), SurfaceType, false, GetClass());
+    }
+    else if (GetNetMode() != NM_DedicatedServer)
     {
-        MulticastSpawnEnvironmentHitParticles();
+        // The clients play the impact of their own copy, only a listen server needs to play this one
+        PlayImpactEffects(GetWorld(), GetActorLocation(), GetActorRotation(), SurfaceType);
     }
-    // This is necessary to avoid the projectile to get destroyed before the multicast is called
-    SetLifeSpan(1.f);
+    StopAfterHit();
+}
+
+void AProjectile::StopAfterHit()
+{
+    // Don't recycle the projectile while the movement component is still handling the hit
+    ProjectileMovement->StopMovementImmediately();
     SetActorEnableCollision(false);
     SetActorHiddenInGame(true);
+    GetWorldTimerManager().SetTimer(RecycleTimer, this, &AProjectile::Recycle, RecycleDelayAfterHit);
 }
 
 void AProjectile::Tick(float DeltaTime)
@@ -2,16 +2,87 @@
 
 #include "Weapon/ProjectileBullet.h"
 
+#include "Components/BoxComponent.h"
 #include "GameFramework/Character.h"
 #include "Kismet/GameplayStatics.h"
+#include "OpenShooter.h"
+#include "Subsystems/LagCompensationSubsystem.h"
+
+void AProjectileBullet::BeginPlay()
+{
+    Super::BeginPlay();
+
+    // On the server the characters are hit through the rewound hitboxes, not through their current mesh.
+    // Clients keep blocking on the mesh, so the cosmetic bullet still stops on the character
+    if (IsAuthoritative() && bUseServerSideRewind && GetCollisionBox())
+        GetCollisionBox()->SetCollisionResponseToChannel(ECC_SkeletalMesh, ECR_Ignore);
+}
+
+void AProjectileBullet::OnLaunched()
+{
+    Super::OnLaunched();
+
+    // The pooled bullet was teleported to the muzzle, the rewound trace must not start from where it was retired
+    LastLocation = GetActorLocation();
+}
+
+void AProjectileBullet::SetFireTime(const float InFireTime)
+{
+    Super::SetFireTime(InFireTime);
+
+    if (const ULagCompensationSubsystem* LagCompensation = GetWorld()->GetSubsystem<ULagCompensationSubsystem>())
+        RewindDelay = GetWorld()->GetTimeSeconds() - LagCompensation->ClampRewindTime(InFireTime);
+}
+
+void AProjectileBullet::Tick(float DeltaTime)
+{
+    Super::Tick(DeltaTime);
+
+    // Collision is disabled once the bullet has hit something
+    if (IsAuthoritative() && bUseServerSideRewind && GetActorEnableCollision())
+        CheckRewoundHit();
+
+    LastLocation = GetActorLocation();
+}
+
+void AProjectileBullet::CheckRewoundHit()
+{
+    // The characters along the path record their real pose since the weapon fired (see AProjectileWeapon::Fire)
+    FHitResult Hit;
+    if (TraceRewound(GetActorLocation(), Hit))
+        OnHit(GetCollisionBox(), Hit.GetActor(), Hit.GetComponent(), FVector::ZeroVector, Hit);
+}
+
+bool AProjectileBullet::TraceRewound(const FVector& End, FHitResult& OutHit) const
+{
+    const ULagCompensationSubsystem* LagCompensation = GetWorld()->GetSubsystem<ULagCompensationSubsystem>();
+    if (LagCompensation == nullptr)
+        return false;
+
+    const float RewindTime = GetWorld()->GetTimeSeconds() - RewindDelay;
+    return LagCompensation->TraceRewound(LastLocation, End, RewindTime, GetOwner(), OutHit);
+}
 
 void AProjectileBullet::OnHit(UPrimitiveComponent* HitComponent, AActor* OtherActor, UPrimitiveComponent* OtherComponent,
     FVector NormalImpulse, const FHitResult& Hit)
 {
+    // The movement stopped on the world this tick, before CheckRewoundHit could test the segment: a rewound character between
+    // the last location and the impact is hit first
+    FHitResult RewoundHit;
+    const bool bWorldHit = IsAuthoritative() && bUseServerSideRewind && !Cast<ACharacter>(OtherActor);
+    const bool bRewoundHit = bWorldHit && TraceRewound(Hit.ImpactPoint, RewoundHit);
+    if (bRewoundHit)
+    {
+        OtherActor = RewoundHit.GetActor();
+        OtherComponent = RewoundHit.GetComponent();
+        NormalImpulse = FVector::ZeroVector;
+    }
+    const FHitResult& FinalHit = bRewoundHit ? RewoundHit : Hit;
+
     if (ACharacter* OwnerCharacter = Cast<ACharacter>(GetOwner()))
         if (AController* OwnerController = OwnerCharacter->GetController())
             UGameplayStatics::ApplyDamage(OtherActor, Damage, OwnerController, this, UDamageType::StaticClass());
 
     // Parent does Destroy, so we need to put this last
-    Super::OnHit(HitComponent, OtherActor, OtherComponent, NormalImpulse, Hit);
+    Super::OnHit(HitComponent, OtherActor, OtherComponent, NormalImpulse, FinalHit);
 }
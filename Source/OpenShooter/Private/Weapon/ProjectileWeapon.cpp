@@ -2,31 +2,72 @@
 
 #include "Weapon/ProjectileWeapon.h"
 
+#include "Character/OpenShooterPlayerController.h"
+#include "Subsystems/LagCompensationSubsystem.h"
+#include "Subsystems/ProjectilePoolSubsystem.h"
 #include "Weapon/Projectile.h"
 
-void AProjectileWeapon::Fire(const FVector& HitTarget)
+void AProjectileWeapon::BeginPlay()
 {
-    Super::Fire(HitTarget);
+    Super::BeginPlay();
 
-    if (!HasAuthority())
-        return;    // Only run on server
+    // The server spawns the projectiles, and the clients their cosmetic copies of the client simulated ones
+    if (HasAuthority() || IsClientSimulated())
+        if (UProjectilePoolSubsystem* Pool = GetWorld()->GetSubsystem<UProjectilePoolSubsystem>())
+            Pool->Prewarm(ProjectileClass, PoolPrewarmCount);
+}
+
+void AProjectileWeapon::Fire(const FVector& HitTarget, const float FireTime, const uint16 FireSequence)
+{
+    Super::Fire(HitTarget, FireTime, FireSequence);
+
+    // Only run on server, or on the clients for a client simulated projectile. Every machine plays the shots, so they all get
+    // here with the same target and sequence, and the scatter below gives them the same direction
+    if (!HasAuthority() && !IsClientSimulated())
+        return;
 
     APawn* InstigatorPawn = Cast<APawn>(GetOwner());
 
     const FTransform SocketTransform = GetMesh()->GetSocketTransform(FName("MuzzleFlash"));
+    FVector Target = HitTarget;
+    if (UsesScatter())
+    {
+        FRandomStream Stream = MakeScatterStream(FireSequence);
+        Target = TraceEndWithScatter(SocketTransform.GetLocation(), HitTarget, Stream);
+    }
     const FVector ToTarget =
-        HitTarget - SocketTransform.GetLocation();    // From the muzzle to hit location from TraceUnderCrosshair
+        Target - SocketTransform.GetLocation();    // From the muzzle to hit location from TraceUnderCrosshair
     const FRotator TargetRotation = ToTarget.Rotation();
     if (ProjectileClass && InstigatorPawn)
     {
-        FActorSpawnParameters SpawnParams;
-        SpawnParams.Owner = GetOwner();
-        SpawnParams.Instigator = InstigatorPawn;
-
-        if (GetWorld())
+        if (UProjectilePoolSubsystem* Pool = GetWorld() ? GetWorld()->GetSubsystem<UProjectilePoolSubsystem>() : nullptr)
         {
-            AProjectile* Projectile =
-                GetWorld()->SpawnActor<AProjectile>(ProjectileClass, SocketTransform.GetLocation(), TargetRotation, SpawnParams);
+            const FTransform SpawnTransform(TargetRotation, SocketTransform.GetLocation());
+            AProjectile* Projectile = Pool->Acquire(ProjectileClass, SpawnTransform, GetOwner(), InstigatorPawn);
+            if (Projectile == nullptr)
+                return;
+            if (HasAuthority())
+            {
+                Projectile->SetFireTime(FireTime);
+
+                // The characters along the path record their real pose until the projectile can no longer hit them
+                if (ULagCompensationSubsystem* LagCompensation = GetWorld()->GetSubsystem<ULagCompensationSubsystem>())
+                    LagCompensation->RequestPoseSamples(
+                        SocketTransform.GetLocation(), Target, Projectile->GetFlightTime(ToTarget.Size()));
+                return;
+            }
+
+            // The server launched its projectile when the shot reached it, catch up with it. The fire time is a single trip
+            // behind the shooter's clock (see UCombatComponent::Fire), which we take off again
+            const AOpenShooterPlayerController* LocalController =
+                Cast<AOpenShooterPlayerController>(GetWorld()->GetFirstPlayerController());
+            if (LocalController)
+                Projectile->FastForward(LocalController->GetServerTime() - LocalController->GetSingleTripTime() - FireTime);
         }
     }
 }
+
+bool AProjectileWeapon::IsClientSimulated() const
+{
+    return ProjectileClass && ProjectileClass->GetDefaultObject<AProjectile>()->IsClientSimulated();
+}
@@ -6,7 +6,10 @@
 #include "Character/OpenShooterPlayerController.h"
 #include "Components/SphereComponent.h"
 #include "Components/WidgetComponent.h"
+#include "GameFramework/PlayerState.h"
+#include "Net/Core/PushModel/PushModel.h"
 #include "Net/UnrealNetwork.h"
+#include "Subsystems/CasingSubsystem.h"
 #include "Weapon/Casing.h"
 
 // Sets default values
@@ -45,10 +48,19 @@ void AWeapon::GetLifetimeReplicatedProps(TArray<FLifetimeProperty>& OutLifetimeP
 {
     Super::GetLifetimeReplicatedProps(OutLifetimeProps);
 
-    DOREPLIFETIME(AWeapon, WeaponState);
-    DOREPLIFETIME(
-        AWeapon, Ammo);    // We replicate the ammo variable to all clients because when the weapon is dropped, the ammo
-                           // should be replicated to the client to show the correct ammo count when the weapon is picked up
+    // Push model: the net driver only compares these after we mark them dirty
+    FDoRepLifetimeParams Params;
+    Params.bIsPushBased = true;
+    DOREPLIFETIME_WITH_PARAMS_FAST(AWeapon, WeaponState, Params);
+    DOREPLIFETIME_WITH_PARAMS_FAST(AWeapon, RestState, Params);
+
+    // Only the owner needs the ammo count. Owner-only properties are sent when the owner changes, so whoever picks up a
+    // dropped weapon still gets the right count. The others only get the magazine state, which rarely changes
+    Params.Condition = COND_OwnerOnly;
+    DOREPLIFETIME_WITH_PARAMS_FAST(AWeapon, Ammo, Params);
+    DOREPLIFETIME_WITH_PARAMS_FAST(AWeapon, AckedFireSequence, Params);
+    Params.Condition = COND_SkipOwner;
+    DOREPLIFETIME_WITH_PARAMS_FAST(AWeapon, MagazineState, Params);
 }
 
 void AWeapon::ShowPickupWidget(const bool bShow) const
@@ -74,6 +86,9 @@ void AWeapon::BeginPlay()
     // Hide the pickup widget initially
     if (PickupWidget)
         PickupWidget->SetVisibility(false);
+
+    if (HasAuthority())
+        SetAmmo(Ammo);
 }
 
 void AWeapon::OnSphereOverlap(UPrimitiveComponent* OverlappedComponent, AActor* OtherActor, UPrimitiveComponent* OtherComp,
@@ -102,6 +117,7 @@ void AWeapon::OnRep_Owner()
         // function)
         OwnerCharacter = nullptr;
         OwnerController = nullptr;
+        UnacknowledgedRounds.Reset();
     }
     else
     {
@@ -119,35 +135,104 @@ void AWeapon::OnRep_Ammo()
     SetHUDWeaponInfo();
 }
 
-void AWeapon::SpendRound()
+void AWeapon::OnRep_AckedFireSequence()
+{
+    // Drop the rounds the server has processed: from now on they are part of Ammo. The difference as int16 handles the wrap
+    UnacknowledgedRounds.RemoveAll([this](const uint16 Sequence)
+        { return static_cast<int16>(Sequence - AckedFireSequence) <= 0; });
+    SetHUDWeaponInfo();
+}
+
+void AWeapon::AcknowledgeFireSequence(const uint16 FireSequence)
+{
+    AckedFireSequence = FireSequence;
+    MARK_PROPERTY_DIRTY_FROM_NAME(AWeapon, AckedFireSequence, this);
+}
+
+void AWeapon::SetAmmo(const int32 NewAmmo)
+{
+    Ammo = FMath::Clamp(NewAmmo, 0, MagCapacity);
+    MARK_PROPERTY_DIRTY_FROM_NAME(AWeapon, Ammo, this);
+
+    EMagazineState NewMagazineState = EMagazineState::EMS_Partial;
+    if (Ammo == 0)
+        NewMagazineState = EMagazineState::EMS_Empty;
+    else if (Ammo == MagCapacity)
+        NewMagazineState = EMagazineState::EMS_Full;
+    COMPARE_ASSIGN_AND_MARK_PROPERTY_DIRTY(AWeapon, MagazineState, NewMagazineState, this);
+
+    // A dormant weapon sends the new ammo once and stays dormant
+    if (NetDormancy > DORM_Awake)
+        FlushNetDormancy();
+}
+
+void AWeapon::SpendRound(const uint16 FireSequence)
 {
-    // After firing, we spend a round
-    // Subtract 1 from ammo
-    Ammo = FMath::Clamp(Ammo - 1, 0, MagCapacity);
+    // After firing, we spend a round: for real on the server, predicted on the owning client. The other clients do not
+    // know the ammo count
+    if (HasAuthority())
+        SetAmmo(Ammo - 1);
+    else if (IsOwnedByLocalPlayer())
+        UnacknowledgedRounds.Add(FireSequence);
+    else
+        return;
     // Update the HUD
     SetHUDWeaponInfo();
 }
 
 void AWeapon::AddAmmo(int32 Amount)
 {
-    Ammo = FMath::Clamp(Ammo + Amount, 0, MagCapacity);
+    SetAmmo(Ammo + Amount);
     SetHUDWeaponInfo();
 }
 
-void AWeapon::Fire(const FVector& HitTarget)
+bool AWeapon::IsOwnedByLocalPlayer() const
+{
+    const APawn* OwnerPawn = Cast<APawn>(GetOwner());
+    return OwnerPawn && OwnerPawn->IsLocallyControlled();
+}
+
+bool AWeapon::IsEmpty() const
+{
+    if (HasAuthority() || IsOwnedByLocalPlayer())
+        return GetAmmo() <= 0;
+    return MagazineState == EMagazineState::EMS_Empty;
+}
+
+void AWeapon::Fire(const FVector& HitTarget, const float FireTime, const uint16 FireSequence)
 {
     if (FireAnimation)
         WeaponMesh->PlayAnimation(FireAnimation, false);
 
-    // Spawn the casing from the Ammo socket
+    // Eject the casing from the Ammo socket
     if (CasingClass)
     {
         const FTransform CasingTransform = WeaponMesh->GetSocketTransform(FName("AmmoEject"));
 
-        if (UWorld* World = GetWorld())
-            ACasing* Casing = World->SpawnActor<ACasing>(CasingClass, CasingTransform);
+        if (UCasingSubsystem* Casings = UWorld::GetSubsystem<UCasingSubsystem>(GetWorld()))
+            Casings->EjectCasing(CasingClass, CasingTransform);
     }
-    SpendRound();    // subtract 1 from ammo and update the HUD
+    SpendRound(FireSequence);    // subtract 1 from ammo and update the HUD
+}
+
+FRandomStream AWeapon::MakeScatterStream(const uint16 FireSequence) const
+{
+    // The player id is the same on every machine, unlike the owner's name or address
+    const APawn* OwnerPawn = Cast<APawn>(GetOwner());
+    const APlayerState* PlayerState = OwnerPawn ? OwnerPawn->GetPlayerState() : nullptr;
+    const uint32 PlayerId = PlayerState ? static_cast<uint32>(PlayerState->GetPlayerId()) : 0u;
+    return FRandomStream(static_cast<int32>(HashCombine(GetTypeHash(PlayerId), GetTypeHash(FireSequence))));
+}
+
+FVector AWeapon::TraceEndWithScatter(const FVector& TraceStart, const FVector& HitTarget, FRandomStream& Stream) const
+{
+    const FVector ToTargetNormalized = (HitTarget - TraceStart).GetSafeNormal();
+    const FVector SphereCenter = TraceStart + ToTargetNormalized * DistanceToSphere;
+    const FVector RandomVector = Stream.VRand() * Stream.FRandRange(0.f, SphereRadius);
+    const FVector EndLocation = SphereCenter + RandomVector;
+    const FVector ToEndLocation = EndLocation - TraceStart;
+
+    return TraceStart + ToEndLocation * TRACE_LENGTH / ToEndLocation.Size();
 }
 
 // This function runs on the server does everything that needs to be done when the weapon state change, on the server.
@@ -156,6 +241,25 @@ void AWeapon::Fire(const FVector& HitTarget)
 void AWeapon::SetWeaponState(const EWeaponState State)
 {
     WeaponState = State;
+    MARK_PROPERTY_DIRTY_FROM_NAME(AWeapon, WeaponState, this);
+
+    if (HasAuthority())
+    {
+        // Any state change wakes the weapon up. A dropped weapon goes back to sleep once its physics settles
+        GetWorldTimerManager().ClearTimer(SettleTimer);
+        SetNetDormancy(DORM_Awake);
+        if (RestState.bAtRest)
+        {
+            RestState.bAtRest = false;
+            MARK_PROPERTY_DIRTY_FROM_NAME(AWeapon, RestState, this);
+        }
+        if (WeaponState == EWeaponState::EWS_Dropped)
+        {
+            SettleTime = 0.f;
+            GetWorldTimerManager().SetTimer(SettleTimer, this, &AWeapon::CheckIfSettled, SettleCheckInterval, true);
+        }
+    }
+
     switch (WeaponState)
     {
         case EWeaponState::EWS_Equipped:
@@ -167,7 +271,7 @@ void AWeapon::SetWeaponState(const EWeaponState State)
             break;
         case EWeaponState::EWS_Dropped:
             if (HasAuthority())    // we use this because we call this function in the client in
-                                   // CombatComponent::OnRep_EquippedWeapon
+                                   // CombatComponent::HandleEquippedWeapon
                 AreaSphere->SetCollisionEnabled(ECollisionEnabled::QueryOnly);
             WeaponMesh->SetSimulatePhysics(true);
             WeaponMesh->SetEnableGravity(true);
@@ -192,12 +296,51 @@ void AWeapon::OnRep_WeaponState(EWeaponState PreviousState)
             WeaponMesh->SetSimulatePhysics(true);
             WeaponMesh->SetEnableGravity(true);
             WeaponMesh->SetCollisionEnabled(ECollisionEnabled::QueryAndPhysics);
+            ApplyRestState();    // joining a game where the weapon already settled
             break;
         default:
             break;
     }
 }
 
+void AWeapon::CheckIfSettled()
+{
+    SettleTime += SettleCheckInterval;
+    if (WeaponMesh->RigidBodyIsAwake() && SettleTime < MaxSettleTime)
+        return;
+
+    GetWorldTimerManager().ClearTimer(SettleTimer);
+    GoDormant();
+}
+
+void AWeapon::GoDormant()
+{
+    // Freeze it where it is so the server and the clients keep agreeing on its position
+    WeaponMesh->SetSimulatePhysics(false);
+
+    RestState.Location = GetActorLocation();
+    RestState.Rotation = GetActorRotation();
+    RestState.bAtRest = true;
+    MARK_PROPERTY_DIRTY_FROM_NAME(AWeapon, RestState, this);
+
+    // The rest state is still sent before the channel closes for dormancy
+    SetNetDormancy(DORM_DormantAll);
+}
+
+void AWeapon::OnRep_RestState()
+{
+    ApplyRestState();
+}
+
+void AWeapon::ApplyRestState()
+{
+    if (!RestState.bAtRest || WeaponState != EWeaponState::EWS_Dropped)
+        return;
+
+    WeaponMesh->SetSimulatePhysics(false);
+    SetActorLocationAndRotation(RestState.Location, RestState.Rotation, false, nullptr, ETeleportType::TeleportPhysics);
+}
+
 void AWeapon::Drop()
 {
     SetWeaponState(EWeaponState::EWS_Dropped);
@@ -223,7 +366,7 @@ void AWeapon::SetHUDWeaponInfo()
             OwnerController == nullptr ? Cast<AOpenShooterPlayerController>(OwnerCharacter->GetController()) : OwnerController;
         if (OwnerController)
         {
-            OwnerController->SetHUDWeaponAmmo(Ammo);
+            OwnerController->SetHUDWeaponAmmo(GetAmmo());
             OwnerController->SetHUDWeaponType(WeaponType);
         }
     }
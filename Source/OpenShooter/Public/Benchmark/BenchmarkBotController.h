@@ -0,0 +1,43 @@
+// Copyright (c) 2024 Rasna Studios. All rights reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "GameFramework/Controller.h"
+
+#include "BenchmarkBotController.generated.h"
+
+/**
+ * Server-only bot used to load the server for network benchmarks: it wanders around the map and jumps from time to time, so its
+ * character keeps replicating like a real player's.
+ *
+ * Spawn them on a listen or dedicated server with "OpenShooter.Bench.SpawnBots <Count>" and remove them with
+ * "OpenShooter.Bench.RemoveBots", then compare "stat net" (and "Net.RepGraph.PrintGraph" with the replication graph enabled).
+ */
+UCLASS()
+class OPENSHOOTER_API ABenchmarkBotController : public AController
+{
+    GENERATED_BODY()
+
+public:
+    ABenchmarkBotController();
+
+    virtual void PostInitializeComponents() override;
+    virtual void Tick(float DeltaSeconds) override;
+
+    // Spawns Count bots with the default pawn of the game mode, at random player starts
+    static void SpawnBots(UWorld* World, int32 Count);
+    static void RemoveBots(UWorld* World);
+
+private:
+    FVector WanderDirection = FVector::ForwardVector;
+    float TimeToNextTurn = 0.f;
+
+    // How often the bot picks a new direction (seconds)
+    UPROPERTY(EditAnywhere, Category = "Benchmark")
+    FVector2D TurnInterval = FVector2D(1.f, 4.f);
+
+    // Chance of jumping every time the bot turns
+    UPROPERTY(EditAnywhere, Category = "Benchmark")
+    float JumpChance = 0.3f;
+};
@@ -2,11 +2,14 @@
 
 #pragma once
 
+#include "Character/CombatRepState.h"
 #include "Components/ActorComponent.h"
 #include "CoreMinimal.h"
 #include "HUD/OpenShooterHUD.h"
 #include "Types/CombatStates.h"
+#include "Weapon/FireBatch.h"
 #include "Weapon/WeaponTypes.h"
+#include "WorldCollision.h"
 
 #include "CombatComponent.generated.h"
 
@@ -26,8 +29,13 @@ public:
     // The character that owns this combat component is a friend of this class
     // This is to allow the character to access the protected and private members of this class
     friend class AOpenShooterCharacter;
+    // The server gets the aiming of the remote players from their moves
+    friend class UOpenShooterMovementComponent;
     virtual void GetLifetimeReplicatedProps(TArray<FLifetimeProperty>& OutLifetimeProps) const override;
 
+    // Measures the bunches sent by our RPCs for the bandwidth profiler (see FNetProfileRPCScope)
+    virtual bool CallRemoteFunction(UFunction* Function, void* Parameters, FOutParmRec* OutParms, FFrame* Stack) override;
+
     virtual void TickComponent(float DeltaTime, ELevelTick TickType, FActorComponentTickFunction* ThisTickFunction) override;
 
     // Equip a weapon
@@ -36,33 +44,50 @@ public:
 protected:
     // Called when the game starts
     virtual void BeginPlay() override;
+    virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
 
-    // Set Aim
+    // Set Aim. The aiming reaches the server with the moves of the client (see UOpenShooterMovementComponent) and then
+    // replicates from the server to all the clients, so the aim speed is predicted and the animations are in sync
     void SetAiming(bool bIsAiming);
 
-    // We need this RPC from the client to tell the server to set the aiming state
-    // This is because the aiming state is handled on the client that pressed the button
-    // and then replicated from the client to the server, and then from the server to all the clients
-    // so that the aiming state is consistent across all clients and the animations are in sync
-    UFUNCTION(Server, Reliable)
-    void ServerSetAiming(bool bIsAiming);
-
-    // We need this to show strafing/leaning animations on all the clients
+    // Clients apply the replicated state in a fixed order: the weapon, the aiming, the combat state and then the shots
     UFUNCTION()
-    void OnRep_EquippedWeapon() const;
-    void Fire();
+    void OnRep_RepState();
+
+    // Server: copies the state below to RepState
+    void UpdateRepState();
+
+    // Attaches the weapon replicated by the server. We need this to show strafing/leaning animations on all the clients
+    void HandleEquippedWeapon() const;
+    void HandleCombatState();
+    // TimeOffset moves the timestamp of the shot back to when it was due (see UpdateFireScheduler)
+    void Fire(float TimeOffset = 0.f);
     bool CanFire() const;
 
     void FireButtonPressed(bool bButtonPressed);
 
-    // This is necessary to replicate the sounds and visuals of the weapon firing
+    // Plays a shot on this machine: the fire montage and the weapon Fire (the weapon decides what only the server does).
+    // FireTime is the server time at which the client fired, so the server can rewind the hitboxes (lag compensation).
+    // Returns false if the shot was not played (empty weapon, or busy)
+    bool PlayFire(const FVector_NetQuantize& TraceHitTarget, float FireTime, uint16 FireSequence);
+
+    // The shots fired during a frame are sent to the server in one RPC, at the end of the frame. The server only plays and
+    // relays the shots that respect the fire delay of the weapon (see IsValidFireTime)
     UFUNCTION(Server, Reliable)
-    void ServerFire(const FVector_NetQuantize& TraceHitTarget);
+    void ServerFireBatch(const FFireBatch& Batch);
+
+    // Cosmetic only, so it can be dropped: the server already applied the hits. Multicasts only reach the connections for
+    // which the character is relevant, and the owner skips it because it played its shots when it fired them
+    UFUNCTION(NetMulticast, Unreliable)
+    void MulticastFireBatch(const FFireBatch& Batch);
 
-    UFUNCTION(NetMulticast, Reliable)
-    void MulticastFire(const FVector_NetQuantize& TraceHitTarget);
+    // Updates HitTarget and OnTarget with a trace under the crosshair. With the default policy the trace is asynchronous, so
+    // we use the result of the previous frame, and it is skipped while the camera and the character stand still
+    // (see OpenShooter.CrosshairTrace.Policy)
+    void TraceUnderCrosshair();
 
-    void TraceUnderCrosshair(FHitResult& HitResult);
+    void OnCrosshairTraceDone(const FTraceHandle& TraceHandle, FTraceDatum& TraceDatum);
+    void SetCrosshairTarget(const FHitResult& HitResult, const FVector& TraceEnd);
 
     void SetHUDCrosshair(float DeltaSeconds);
 
@@ -89,28 +114,74 @@ private:
     UPROPERTY()
     AOpenShooterHUD* HUD;
 
-    UPROPERTY(ReplicatedUsing = OnRep_EquippedWeapon)
+    // The server replicates the state below as a whole (see FCombatRepState)
+    UPROPERTY(ReplicatedUsing = OnRep_RepState)
+    FCombatRepState RepState;
+
+    // The state applied on this machine
+    UPROPERTY()
     AWeapon* EquippedWeapon;
 
-    UPROPERTY(ReplicatedUsing = OnRep_CombatState)
     ECombatState CombatState = ECombatState::ECS_Unoccupied;
 
-    UFUNCTION()
-    void OnRep_CombatState();
-
-    UPROPERTY(Replicated)
     bool bAiming;
 
+    // Simulated proxies: the fire count of the shots received with MulticastFireBatch. If RepState gets ahead, the multicast
+    // was dropped and we still play the fire montage. The server only relays the shots it counted, so it never gets behind
+    uint8 PlayedFireCount = 0;
+
     UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Movement", meta = (AllowPrivateAccess = "true"))
     float BaseWalkSpeed;
 
+    // Handed to the movement component (MaxWalkSpeedAiming) in BeginPlay
     UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Movement", meta = (AllowPrivateAccess = "true"))
     float AimWalkSpeed;
 
     bool bFireButtonPressed;    // we don't replicate this because we could have automatic weapons, so it would be hard
     // to replicate the changes in the button press state. We use instead multicast RPCs
 
-    bool bCanFire = true;
+    // Time left before the next shot. The automatic fire keeps the remainder (negative) so the shots stay on a fixed step
+    float FireCooldown = 0.f;
+
+    // The last shot emptied the magazine: reload once the cooldown is over
+    bool bReloadWhenReady = false;
+
+    // Guards the scheduler against weapons with no fire delay
+    static constexpr float MinFireDelay = 0.01f;
+
+    // Shots fired by the local player this frame, not sent yet
+    FFireBatch PendingShots;
+
+    // Sequence number of the next shot of the local player. The weapon uses it to predict the ammo until the server
+    // acknowledges the shot. Starts at 1, as the weapons replicate an acknowledgement of 0 before any shot
+    uint16 NextFireSequence = 1;
+
+    // Server: last fire sequence of the owner processed, acknowledged again on every weapon it equips so a weapon
+    // never carries the acknowledgement of its previous owner
+    uint16 AckedFireSequence = 0;
+
+    // Server: fire time of the last shot accepted from the owner
+    float LastAcceptedFireTime = TNumericLimits<float>::Lowest();
+
+    // Server: slack on the fire delay between two shots, for the fire times sent in milliseconds and the clock corrections of
+    // the client (seconds)
+    static constexpr float FireTimeTolerance = 0.01f;
+
+    // Server: older shots are refused, so a client can not bank its shots while idle and fire them all at once (seconds)
+    static constexpr float MaxFireTimeAge = 1.f;
+
+    // Server: the shot is not in the future, comes after PreviousFireTime (the previous shot of the batch) and at least the
+    // fire delay of the weapon after the last accepted shot
+    bool IsValidFireTime(float FireTime, float PreviousFireTime) const;
+
+    // World time of the last shot played on this machine (the character replicates faster while firing)
+    float LastFireTime = -1.f;
+
+    FDelegateHandle PostActorTickHandle;
+
+    // Called after every actor ticked (and the fire timers ran) and before the net driver sends this frame's RPCs
+    void OnWorldPostActorTick(UWorld* World, ELevelTick TickType, float DeltaSeconds);
+    void FlushPendingShots();
 
     // = HUD and Crosshair =
 
@@ -145,6 +216,26 @@ private:
     FVector HitTarget;
     bool OnTarget;    // if the crosshair is on a enemy target
 
+    FTraceDelegate CrosshairTraceDelegate;
+
+    // View and character when we issued the last crosshair trace, to know if it can be reused
+    FVector LastTraceViewLocation = FVector::ZeroVector;
+    FVector LastTraceViewDirection = FVector::ZeroVector;
+    FVector LastTraceCharacterLocation = FVector::ZeroVector;
+    float LastTraceTime = -1.f;
+
+    // The crosshair trace is reused while the camera and the character moved less than this (cm)
+    UPROPERTY(EditAnywhere, Category = "HUD")
+    float CrosshairReuseDistance = 1.f;
+
+    // ... and the camera turned less than this (degrees)
+    UPROPERTY(EditAnywhere, Category = "HUD")
+    float CrosshairReuseAngle = 0.1f;
+
+    // ... and for at most this long, so characters walking into the crosshair are still noticed (seconds)
+    UPROPERTY(EditAnywhere, Category = "HUD")
+    float CrosshairMaxReuseTime = 0.1f;
+
     // = Aim and FOV =
     UPROPERTY(EditAnywhere, Category = "Combat")
     float DefaultFOV;    // FOV when not aiming set to the camera's base FOV in BeginPlay
@@ -161,10 +252,9 @@ private:
 
     // = Automatic FireButtonPressed =
 
-    FTimerHandle FireTimer;
-
-    void StartFireTimer();       // To start the timer
-    void FireTimerFinished();    // Callback called when the timer finishes
+    // Runs the fire cooldown and fires every automatic shot that became due during the frame, however long the frame was,
+    // so the fire rate does not depend on the frame rate
+    void UpdateFireScheduler(float DeltaTime);
 
     // = Weapons =
 
@@ -176,4 +266,7 @@ private:
 
     UPROPERTY(EditAnywhere, Category = "Combat")
     TMap<EWeaponType, int32> CarriedAmmoMap;    // maps cannot be replicated, so we use the CarriedAmmo variable
+
+public:
+    FORCEINLINE EWeaponType GetEquippedWeaponType() const { return RepState.WeaponType; }
 };
@@ -0,0 +1,58 @@
+// Copyright (c) 2024 Rasna Studios. All rights reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Types/CombatStates.h"
+#include "Weapon/WeaponTypes.h"
+
+#include "CombatRepState.generated.h"
+
+class AWeapon;
+
+/**
+ * Everything the other machines need to know about the combat of a character, replicated as a single property.
+ *
+ * The flags are packed in 12 bits (aiming, combat state, weapon type and a wrapping counter of the shots the server played)
+ * followed by the equipped weapon reference, so one change costs one property header, and the receiver gets the whole state at
+ * once in a single OnRep instead of separate OnReps in no particular order.
+ */
+USTRUCT()
+struct FCombatRepState
+{
+    GENERATED_BODY()
+
+    static constexpr uint32 FireCountBits = 6;
+    static constexpr uint32 FireCountMask = (1 << FireCountBits) - 1;
+
+    UPROPERTY()
+    TObjectPtr<AWeapon> EquippedWeapon;
+
+    // Known even while the weapon actor is not mapped on the client yet
+    EWeaponType WeaponType = EWeaponType::EWT_MAX;
+
+    ECombatState CombatState = ECombatState::ECS_Unoccupied;
+
+    bool bAiming = false;
+
+    // Shots played by the server, wraps at FireCountMask
+    uint8 FireCount = 0;
+
+    bool operator==(const FCombatRepState& Other) const
+    {
+        return EquippedWeapon == Other.EquippedWeapon && WeaponType == Other.WeaponType && CombatState == Other.CombatState &&
+               bAiming == Other.bAiming && FireCount == Other.FireCount;
+    }
+
+    bool NetSerialize(FArchive& Ar, UPackageMap* Map, bool& bOutSuccess);
+};
+
+template <>
+struct TStructOpsTypeTraits<FCombatRepState> : public TStructOpsTypeTraitsBase2<FCombatRepState>
+{
+    enum
+    {
+        WithNetSerializer = true,
+        WithIdenticalViaEquality = true,    // the packed fields are not UPROPERTYs, the default comparison would miss them
+    };
+};
@@ -0,0 +1,58 @@
+// Copyright (c) 2024 Rasna Studios. All rights reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+#include "HealthRepState.generated.h"
+
+// Where the last hit came from, relative to the character. Picks the section of the hit react montage
+UENUM(BlueprintType)
+enum class EHitDirection : uint8
+{
+    EHD_Front UMETA(DisplayName = "Front"),
+    EHD_Back UMETA(DisplayName = "Back"),
+    EHD_Left UMETA(DisplayName = "Left"),
+    EHD_Right UMETA(DisplayName = "Right"),
+
+    EHD_MAX UMETA(DisplayName = "DefaultMax"),
+};
+
+/**
+ * The health of a character as the clients see it, replicated as a single property.
+ *
+ * The health is rounded up to whole points (what the HUD shows) and sent in 8 bits, or 16 above 255. The hit counter wraps
+ * every 16 hits: the clients play one hit react per hit counted since the last update, even when several hits land in the
+ * same net update, and the direction of the last hit picks the montage section.
+ */
+USTRUCT()
+struct FHealthRepState
+{
+    GENERATED_BODY()
+
+    static constexpr uint32 HitCountBits = 4;
+    static constexpr uint32 HitCountMask = (1 << HitCountBits) - 1;
+
+    uint16 Health = 0;
+
+    uint8 HitCount = 0;
+
+    EHitDirection LastHitDirection = EHitDirection::EHD_Front;
+
+    bool operator==(const FHealthRepState& Other) const
+    {
+        return Health == Other.Health && HitCount == Other.HitCount && LastHitDirection == Other.LastHitDirection;
+    }
+
+    bool NetSerialize(FArchive& Ar, UPackageMap* Map, bool& bOutSuccess);
+};
+
+template <>
+struct TStructOpsTypeTraits<FHealthRepState> : public TStructOpsTypeTraitsBase2<FHealthRepState>
+{
+    enum
+    {
+        WithNetSerializer = true,
+        WithIdenticalViaEquality = true,    // no UPROPERTY to compare
+    };
+};
@@ -0,0 +1,175 @@
+// Copyright (c) 2024 Rasna Studios. All rights reserved.
+
+#pragma once
+
+#include "Components/ActorComponent.h"
+#include "CoreMinimal.h"
+
+#include "LagCompensationComponent.generated.h"
+
+class AOpenShooterCharacter;
+
+// A capsule hitbox spanning two bones of the character skeleton (a sphere if EndBone is None)
+USTRUCT(BlueprintType)
+struct FLagCompensationHitbox
+{
+    GENERATED_BODY()
+
+    UPROPERTY(EditAnywhere)
+    FName StartBone;
+
+    UPROPERTY(EditAnywhere)
+    FName EndBone;
+
+    UPROPERTY(EditAnywhere)
+    float Radius = 10.f;
+
+    // The hitbox pitches with the aim (head and arms) when the pose is procedural
+    UPROPERTY(EditAnywhere)
+    bool bFollowsAimPitch = false;
+};
+
+// The result of a segment test against a rewound pose
+struct FRewindHit
+{
+    FVector ImpactPoint = FVector::ZeroVector;
+    float Distance = 0.f;    // distance from the start of the segment
+    int32 HitboxIndex = INDEX_NONE;
+};
+
+/**
+ * Server side rewind for the character hitboxes.
+ *
+ * Every server tick we record the world position of each hitbox capsule in a fixed-size ring buffer. When a client
+ * reports a shot, the server can then test the shot against the pose that the client was seeing when it pulled the trigger,
+ * instead of the pose the victim has on the server right now.
+ *
+ * The history is stored as a structure of arrays: one array for the frame times, one for the frame centers (used for the broad
+ * phase) and two flat arrays for the capsule segments, indexed by Frame * NumHitboxes + Hitbox. Everything is allocated once in
+ * BeginPlay, so recording a frame is just a handful of bone lookups and copies.
+ *
+ * On a dedicated server nobody looks at the meshes, so their animation is not evaluated (only the montages tick, for their
+ * notifies). The hitboxes are then recorded procedurally: a template of the pose of each stance is placed at the actor location
+ * and yaw, and the upper body is pitched with the aim. The real pose is still sampled every PoseSampleInterval, so the history
+ * always holds recent real frames, even for the first shot of an engagement. When a shot is fired near the character, the real
+ * pose is sampled every frame for as long as the shot can be rewound (RequestPoseSample). A sample only replaces the template
+ * of its stance in a neutral pose (no montage, grounded, standing still), so a reload or a hit react is never reused.
+ * Disable with "OpenShooter.Server.ProceduralPose 0".
+ */
+UCLASS(ClassGroup = (Custom), meta = (BlueprintSpawnableComponent))
+class OPENSHOOTER_API ULagCompensationComponent : public UActorComponent
+{
+    GENERATED_BODY()
+
+public:
+    ULagCompensationComponent();
+    friend class AOpenShooterCharacter;
+
+    virtual void TickComponent(float DeltaTime, ELevelTick TickType, FActorComponentTickFunction* ThisTickFunction) override;
+
+    // Tests the segment against the hitboxes as they were at the given server time. Returns true on hit.
+    bool IntersectSegmentAtTime(const FVector& Start, const FVector& End, float Time, FRewindHit& OutHit) const;
+
+    // Batched version for segments sharing the same start (shotgun pellets): the pose is interpolated only once.
+    // OutHits must have the same size as Ends. Returns the number of segments that hit.
+    int32 IntersectSegmentsAtTime(
+        const FVector& Start, TArrayView<const FVector> Ends, float Time, TArrayView<FRewindHit> OutHits) const;
+
+    // Oldest server time we can still rewind to
+    float GetOldestRecordedTime() const;
+
+    // Server: the frames of the next Duration seconds are recorded from the evaluated pose, not the procedural one (a shot is
+    // coming)
+    void RequestPoseSample(float Duration);
+
+    // Server: evaluates the real pose now if the procedural pose left the mesh behind (the weapon fires from its muzzle socket)
+    void EvaluatePose();
+
+    FORCEINLINE float GetMaxRewindTime() const { return MaxRewindTime; }
+    FORCEINLINE AOpenShooterCharacter* GetCharacter() const { return Character; }
+
+protected:
+    virtual void BeginPlay() override;
+    virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
+
+private:
+    UPROPERTY()
+    AOpenShooterCharacter* Character;
+
+    // The capsules that make up the character hitbox. Bone names refer to the character skeleton
+    UPROPERTY(EditAnywhere, Category = "Lag Compensation")
+    TArray<FLagCompensationHitbox> Hitboxes;
+
+    // How far back in time the server can rewind (seconds)
+    UPROPERTY(EditAnywhere, Category = "Lag Compensation")
+    float MaxRewindTime = 0.4f;
+
+    // Number of frames kept in the history. Frames are recorded at most every MaxRewindTime / MaxFrames seconds, so the whole
+    // rewind window is always covered regardless of the server tick rate
+    UPROPERTY(EditAnywhere, Category = "Lag Compensation")
+    int32 MaxFrames = 32;
+
+    // Radius of the sphere around the actor location that encloses all the hitboxes (broad phase)
+    UPROPERTY(EditAnywhere, Category = "Lag Compensation")
+    float BoundsRadius = 120.f;
+
+    void RecordFrame(float Time);
+
+    // Finds the two frames around Time and the alpha between them. Returns false if the history is empty
+    bool FindFrames(float Time, int32& OutOlder, int32& OutNewer, float& OutAlpha) const;
+
+    // = History (SoA ring buffer) =
+
+    TArray<float> FrameTimes;
+    TArray<FVector> FrameCenters;
+    TArray<FVector> SegmentStarts;
+    TArray<FVector> SegmentEnds;
+    TArray<float> Radii;    // constant, copied from the hitboxes so the hot loop does not touch the UPROPERTY array
+
+    int32 NumHitboxes = 0;
+    int32 Head = INDEX_NONE;    // index of the most recent frame
+    int32 NumRecorded = 0;
+    float MinRecordInterval = 0.f;
+
+    // = Procedural pose (dedicated server) =
+
+    // The hitboxes of a real pose, relative to the actor location and yaw
+    struct FPoseTemplate
+    {
+        TArray<FVector> Starts;
+        TArray<FVector> Ends;
+        FVector AimPivot = FVector::ZeroVector;
+        float AimPitch = 0.f;
+        bool bValid = false;
+    };
+
+    FPoseTemplate StandingPose;
+    FPoseTemplate CrouchedPose;
+
+    bool bProceduralPose = false;
+    float PoseSampleEndTime = 0.f;
+    float NextPoseSampleTime = 0.f;
+    uint64 PoseEvaluationFrame = 0;
+
+    // The bone the upper body hitboxes pitch around
+    UPROPERTY(EditAnywhere, Category = "Lag Compensation|Procedural Pose")
+    FName AimPivotBone = FName("spine_03");
+
+    // The real pose is sampled at least this often, even with no shot around (seconds)
+    UPROPERTY(EditAnywhere, Category = "Lag Compensation|Procedural Pose")
+    float PoseSampleInterval = 0.2f;
+
+    // Above this speed the pose is not neutral, it does not replace a template (cm/s)
+    UPROPERTY(EditAnywhere, Category = "Lag Compensation|Procedural Pose")
+    float NeutralPoseMaxSpeed = 10.f;
+
+    // Evaluates the animation now and records the real hitboxes in the history. They also become the template of the current
+    // stance if it has none yet, or if the pose is neutral
+    void RecordSampledFrame(int32 Base, FPoseTemplate& Template);
+
+    bool IsNeutralPose() const;
+
+    void RecordProceduralFrame(int32 Base, const FPoseTemplate& Template);
+
+    FTransform GetReferenceTransform() const;
+};
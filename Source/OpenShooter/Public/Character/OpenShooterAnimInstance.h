@@ -4,13 +4,48 @@
 
 #include "Animation/AnimInstance.h"
 #include "CoreMinimal.h"
+#include "Types/CombatStates.h"
 #include "Types/TurningInPlace.h"
 
 #include "OpenShooterAnimInstance.generated.h"
 
 class AOpenShooterCharacter;
+
+// What the animation update needs from the character, copied on the game thread
+struct FOpenShooterAnimSnapshot
+{
+    FVector Velocity = FVector::ZeroVector;
+    FRotator AimRotation = FRotator::ZeroRotator;
+    FRotator ActorRotation = FRotator::ZeroRotator;
+    FVector HitTarget = FVector::ZeroVector;
+
+    // World transforms of the weapon hand sockets and of the right hand bone, valid if bHasWeaponMesh
+    FTransform LeftHandSocket = FTransform::Identity;
+    FTransform RightHandSocket = FTransform::Identity;
+    FTransform RightHandBone = FTransform::Identity;
+
+    float AimOffsetYaw = 0.f;
+    float AimOffsetPitch = 0.f;
+    ETurningInPlace TurningInPlace = ETurningInPlace::ETIP_NotTurning;
+    ECombatState CombatState = ECombatState::ECS_Unoccupied;
+
+    bool bValid = false;
+    bool bIsFalling = false;
+    bool bIsAccelerating = false;
+    bool bIsCrouched = false;
+    bool bIsAiming = false;
+    bool bRotateRootBone = false;
+    bool bEliminated = false;
+    bool bWeaponEquipped = false;
+    bool bHasWeaponMesh = false;
+    bool bLocallyControlled = false;
+    bool bReducedDetail = false;
+};
+
 /**
- *
+ * The update is split in two: NativeUpdateAnimation copies a snapshot of the character on the game thread (a few getters and
+ * three socket reads) and NativeThreadSafeUpdateAnimation does all the math from the snapshot on a worker thread, in parallel
+ * with the other characters. The thread safe part must not touch the character or its components.
  */
 UCLASS()
 class OPENSHOOTER_API UOpenShooterAnimInstance : public UAnimInstance
@@ -20,8 +55,19 @@ class OPENSHOOTER_API UOpenShooterAnimInstance : public UAnimInstance
 public:
     virtual void NativeInitializeAnimation() override;
     virtual void NativeUpdateAnimation(float DeltaSeconds) override;
+    virtual void NativeThreadSafeUpdateAnimation(float DeltaSeconds) override;
+
+    // Game thread: skips the left hand IK and the right hand look-at (see UAnimationBudgetSubsystem)
+    FORCEINLINE void SetReducedDetail(const bool bInReducedDetail) { bReducedDetail = bInReducedDetail; }
 
 private:
+    // Game thread: fills the snapshot
+    void GatherSnapshot();
+
+    FOpenShooterAnimSnapshot Snapshot;
+
+    bool bReducedDetail = false;
+
     UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "Movement", meta = (AllowPrivateAccess = "true"))
     TObjectPtr<AOpenShooterCharacter> OpenShooterCharacter;
 
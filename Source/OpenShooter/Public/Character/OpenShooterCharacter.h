@@ -6,8 +6,10 @@
 #include "Components/TimelineComponent.h"
 #include "CoreMinimal.h"
 #include "GameFramework/Character.h"
+#include "HealthRepState.h"
 #include "Interfaces/InteractWithCrosshairInterface.h"
 #include "Logging/LogMacros.h"
+#include "ProxySnapshotBuffer.h"
 #include "Types/TurningInPlace.h"
 
 #include "OpenShooterCharacter.generated.h"
@@ -15,6 +17,7 @@
 class AOpenShooterPlayerState;
 class UTimelineComponent;
 class UCombatComponent;
+class ULagCompensationComponent;
 class AWeapon;
 class UWidgetComponent;
 class USpringArmComponent;
@@ -32,9 +35,12 @@ class AOpenShooterCharacter : public ACharacter, public IInteractWithCrosshairIn
     GENERATED_BODY()
 
 public:
-    AOpenShooterCharacter();
+    AOpenShooterCharacter(const FObjectInitializer& ObjectInitializer);
     virtual void GetLifetimeReplicatedProps(TArray<FLifetimeProperty>& OutLifetimeProps) const override;
 
+    // Measures the bunches sent by our RPCs for the bandwidth profiler (see FNetProfileRPCScope)
+    virtual bool CallRemoteFunction(UFunction* Function, void* Parameters, FOutParmRec* OutParms, FFrame* Stack) override;
+
     void SetOverlappingWeapon(AWeapon* Weapon);
 
     bool IsWeaponEquipped() const;
@@ -43,18 +49,20 @@ public:
 
     void PlayFireMontage(bool bAiming) const;
     void PlayReloadMontage() const;
-    void PlayHitReactMontage() const;
+    void PlayHitReactMontage(EHitDirection Direction) const;
 
-    UFUNCTION(NetMulticast, Unreliable)    // Easiest implementation for the client to play the impact effects
-    void MulticastPlayImpactEffects(FVector_NetQuantize ImpactPoint);
+    // Plays the hit sound and particles. Called on the class defaults by UImpactEventSubsystem
+    void PlayHitEffects(UWorld* World, const FVector& ImpactPoint) const;
 
-    // We need to run the simulated proxies' turn in place only when necessary instead of doing in tick (because tick is not fast
-    // enough)
-    virtual void OnRep_ReplicatedMovement() override;
+    // Simulated proxies: records the state received in the snapshot buffer (the view pitch does not come with the movement)
+    virtual void PostNetReceive() override;
 
     void Eliminate();
     void PlayEliminationMontage() const;
 
+    // Server: the character moved, aimed, turned the camera or fired in the last NetActivityTimeout seconds
+    bool IsNetActive() const;
+
 private:
     /** Camera boom positioning the camera behind the character */
     UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "Components|Camera", meta = (AllowPrivateAccess = "true"))
@@ -116,6 +124,10 @@ private:
     UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "Components|Combat", meta = (AllowPrivateAccess = "true"))
     UCombatComponent* Combat;
 
+    // Records the hitbox history on the server for the server side rewind
+    UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "Components|Combat", meta = (AllowPrivateAccess = "true"))
+    ULagCompensationComponent* LagCompensation;
+
     UPROPERTY()
     AOpenShooterPlayerController* PlayerController;
 
@@ -129,16 +141,47 @@ private:
 
     // Player Health
 
-    // This will be called on the clients when the Health variable is updated on the server
+    // This will be called on the clients when the health state is updated on the server
     UFUNCTION()
-    void OnRep_Health();
+    void OnRep_HealthState();
 
     UPROPERTY(EditAnywhere, Category = "Player Stats")
     float MaxHealth = 100.f;
 
-    UPROPERTY(ReplicatedUsing = OnRep_Health, VisibleAnywhere, Category = "Player Stats")
+    // Authoritative on the server. The clients set it from HealthState
+    UPROPERTY(VisibleAnywhere, Category = "Player Stats")
     float Health = MaxHealth;
 
+    UPROPERTY(ReplicatedUsing = OnRep_HealthState)
+    FHealthRepState HealthState;
+
+    // The hit counter of the last HealthState we received, and whether we received one yet (a late joiner does not replay
+    // the hits of the past)
+    uint8 ReceivedHitCount = 0;
+    bool bHealthStateReceived = false;
+
+    // Server: updates HealthState after a hit
+    void UpdateHealthState(EHitDirection HitDirection);
+
+    EHitDirection GetHitDirection(const AActor* DamageCauser) const;
+
+    // The type of the weapon that dealt the damage, EWT_MAX if unknown
+    static EWeaponType GetDamageCauserWeaponType(const AActor* DamageCauser);
+
+    // Hit reacts still to play. They are spread over HitReactInterval so that several hits in one update all show
+    int32 PendingHitReacts = 0;
+    EHitDirection PendingHitDirection = EHitDirection::EHD_Front;
+    float NextHitReactTime = 0.f;
+
+    UPROPERTY(EditAnywhere, Category = "Combat")
+    float HitReactInterval = 0.12f;
+
+    UPROPERTY(EditAnywhere, Category = "Combat")
+    int32 MaxPendingHitReacts = 3;
+
+    void QueueHitReacts(int32 Count, EHitDirection Direction);
+    void UpdateHitReacts();
+
     UFUNCTION()    // Bound to OnTakeAnyDamage event in BeginPlay. It is called when the ProjectileBullet calls ApplyDamage to char
     void ReceiveDamage(
         AActor* DamagedActor, float Damage, const UDamageType* DamageType, AController* InstigatorController, AActor* DamageCauser);
@@ -170,6 +213,7 @@ protected:
     virtual void SetupPlayerInputComponent(class UInputComponent* PlayerInputComponent) override;
 
     virtual void BeginPlay() override;
+    virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
     virtual void PostInitializeComponents() override;
     virtual void Tick(float DeltaSeconds) override;
 
@@ -194,11 +238,12 @@ protected:
     // Aiming
     void AimPressed();
     void AimReleased();
-    void CalculateAimOffsetPitch();
+    float CalculateAimOffsetPitch() const;
     float CalculateSpeed() const;
     void AimOffset(float DeltaSeconds);
 
-    void SimProxiesTurn();    // Simulated proxies cannot smoothly turn in place, so we need to simulate it
+    // Simulated proxies cannot smoothly turn in place, so we need to simulate it from the snapshot buffer
+    void SimProxiesTurn();
 
     // FireButtonPressed
     void FirePressed();
@@ -244,12 +289,50 @@ private:
     // This will happen only in server or autonomous proxy. Therefore, we need this to blend poses by bool
     bool bRotateRootBone = false;
 
-    // We need these to tell the clients to play the turn in place animation (because the simulated proxies cannot turn in place)
-    float TurnThreshold = 0.5f;
-    FRotator ProxyRotationLastFrame;
-    FRotator ProxyRotation;
-    float ProxyYaw;
-    float TimeSinceLastMovementReplication;
+    // Simulated proxies: the updates received, played some time in the past so the aim pitch and the turn in place do not
+    // depend on the net update rate (see SimProxiesTurn)
+    FProxySnapshotBuffer ProxySnapshots;
+
+    // The shortest delay the updates are played with (seconds)
+    UPROPERTY(EditAnywhere, Category = "Replication")
+    float ProxyInterpolationDelay = 0.1f;
+
+    // The delay also covers this many update intervals, as measured for each proxy: the replication graph sends the far and
+    // hidden ones less often
+    UPROPERTY(EditAnywhere, Category = "Replication")
+    float ProxyInterpolationIntervals = 1.5f;
+
+    // Past this time without an update, the proxy was idle: its previous state is held instead of interpolated (seconds)
+    UPROPERTY(EditAnywhere, Category = "Replication")
+    float ProxyMaxSnapshotGap = 0.5f;
+
+    // How long we keep going at the last rates when the next update is late, before holding (seconds)
+    UPROPERTY(EditAnywhere, Category = "Replication")
+    float ProxyMaxExtrapolation = 0.1f;
+
+    // A standing proxy turning faster than this plays the turn in place animation (degrees per second)
+    UPROPERTY(EditAnywhere, Category = "Replication")
+    float ProxyTurnRateThreshold = 30.f;
+
+    // Adaptive replication rate (server). An idle character replicates at IdleNetUpdateFrequency instead of the class rate.
+    // The replication graph then scales this rate per connection with the distance and the visibility (see
+    // UOpenShooterReplicationGraph::GetCharacterNetRate)
+
+    UPROPERTY(EditAnywhere, Category = "Replication")
+    float NetActivityTimeout = 1.f;
+
+    UPROPERTY(EditAnywhere, Category = "Replication")
+    float IdleNetUpdateFrequency = 20.f;
+
+    // A control rotation change above this keeps the character active, so a standing player sweeping the camera still
+    // replicates its aim at the full rate (degrees per tick)
+    UPROPERTY(EditAnywhere, Category = "Replication")
+    float NetActivityRotationThreshold = 0.5f;
+
+    float LastNetActivityTime = -1.f;
+    FRotator LastNetActivityRotation = FRotator::ZeroRotator;
+
+    void UpdateNetActivity();
 
     // Dissolve effect
 
@@ -285,6 +368,10 @@ public:
     FORCEINLINE bool IsEliminated() const { return bEliminated; }
     FORCEINLINE float GetHealth() const { return Health; }
     FORCEINLINE float GetMaxHealth() const { return MaxHealth; }
+    FORCEINLINE ULagCompensationComponent* GetLagCompensation() const { return LagCompensation; }
+    FORCEINLINE UCombatComponent* GetCombat() const { return Combat; }
+    FORCEINLINE UWidgetComponent* GetOverHeadWidget() const { return OverHeadWidget; }
+    FORCEINLINE UTimelineComponent* GetDissolveTimeline() const { return DissolveTimeline; }
 
     AWeapon* GetEquippedWeapon() const;
     ECombatState GetCombatState() const;
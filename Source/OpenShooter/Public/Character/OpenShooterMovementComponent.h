@@ -0,0 +1,66 @@
+// Copyright (c) 2024 Rasna Studios. All rights reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "GameFramework/CharacterMovementComponent.h"
+
+#include "OpenShooterMovementComponent.generated.h"
+
+/**
+ * Character movement with a predicted aim speed.
+ *
+ * The aiming is part of the moves, like the crouch: the owning client saves it with every move (FLAG_Custom_0 of the compressed
+ * flags), so the server applies the aim speed at the same move as the client and replays agree with it. No RPC, and no
+ * correction when aiming starts or stops while moving.
+ *
+ * The server learns about the aiming from the moves and hands it to the combat component, which replicates it to the others.
+ */
+UCLASS()
+class OPENSHOOTER_API UOpenShooterMovementComponent : public UCharacterMovementComponent
+{
+    GENERATED_BODY()
+
+public:
+    virtual float GetMaxSpeed() const override;
+    virtual void UpdateFromCompressedFlags(uint8 Flags) override;
+    virtual bool ClientUpdatePositionAfterServerUpdate() override;
+    virtual FNetworkPredictionData_Client* GetPredictionData_Client() const override;
+
+    // Locally controlled: starts or stops aiming with the next move
+    void SetWantsToAim(const bool bInWantsToAim) { bWantsToAim = bInWantsToAim; }
+    FORCEINLINE bool WantsToAim() const { return bWantsToAim; }
+
+    // Max walk speed while aiming. Crouching is slower and wins
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Character Movement: Walking",
+        meta = (ClampMin = "0", UIMin = "0", ForceUnits = "cm/s"))
+    float MaxWalkSpeedAiming = 400.f;
+
+private:
+    // Set by the input on the owning client, by the moves of the client on the server
+    bool bWantsToAim = false;
+};
+
+class OPENSHOOTER_API FSavedMove_OpenShooter : public FSavedMove_Character
+{
+public:
+    typedef FSavedMove_Character Super;
+
+    virtual void Clear() override;
+    virtual uint8 GetCompressedFlags() const override;
+    virtual bool CanCombineWith(const FSavedMovePtr& NewMove, ACharacter* InCharacter, float MaxDelta) const override;
+    virtual void SetMoveFor(ACharacter* C, float InDeltaTime, FVector const& NewAccel,
+        FNetworkPredictionData_Client_Character& ClientData) override;
+
+    bool bSavedWantsToAim = false;
+};
+
+class OPENSHOOTER_API FNetworkPredictionData_Client_OpenShooter : public FNetworkPredictionData_Client_Character
+{
+public:
+    typedef FNetworkPredictionData_Client_Character Super;
+
+    explicit FNetworkPredictionData_Client_OpenShooter(const UCharacterMovementComponent& ClientMovement);
+
+    virtual FSavedMovePtr AllocateNewMove() override;
+};
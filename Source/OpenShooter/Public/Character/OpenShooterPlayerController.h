@@ -4,6 +4,7 @@
 
 #include "CoreMinimal.h"
 #include "GameFramework/PlayerController.h"
+#include "Weapon/ImpactBatch.h"
 
 #include "OpenShooterPlayerController.generated.h"
 
@@ -23,16 +24,57 @@ public:
     void SetHUDHealth(float Health, float MaxHealth);
     void SetHUDScore(float Score);
     void SetHUDDefeats(int32 Defeats);
-    void SetHUDAnnoucement(const FString& Message, float DisplayTime = 5.0f);
+    void SetHUDAnnoucement(const FText& Message, float DisplayTime = 5.0f);
     void ClearAnnoucementText();
     void SetHUDWeaponAmmo(int32 Ammo);
     void SetHUDWeaponType(EWeaponType WeaponType);
     void SetHUDCarriedAmmo(int32 Ammo);
 
+    virtual void Tick(float DeltaSeconds) override;
+
+    // Sync with the server clock as soon as possible
+    virtual void ReceivedPlayer() override;
+
+    // Measures the bunches sent by our RPCs for the bandwidth profiler (see FNetProfileRPCScope)
+    virtual bool CallRemoteFunction(UFunction* Function, void* Parameters, FOutParmRec* OutParms, FFrame* Stack) override;
+
+    // Current time on the server, estimated on the client. Used to timestamp shots for the server side rewind
+    float GetServerTime() const;
+
+    FORCEINLINE float GetSingleTripTime() const { return SingleTripTime; }
+
+    // The impacts of a server frame around this player (see UImpactEventSubsystem). Cosmetic, so it can be dropped
+    UFUNCTION(Client, Unreliable)
+    void ClientPlayImpacts(const FImpactBatch& Batch);
+
 protected:
     virtual void BeginPlay() override;
     virtual void OnPossess(APawn* InPawn) override;
 
+    // = Server time sync =
+
+    // Requests the current server time, passing in the client's time when the request was sent
+    UFUNCTION(Server, Reliable)
+    void ServerRequestServerTime(float TimeOfClientRequest);
+
+    // Reports the current server time to the client in response to ServerRequestServerTime
+    UFUNCTION(Client, Reliable)
+    void ClientReportServerTime(float TimeOfClientRequest, float TimeServerReceivedClientRequest);
+
 private:
     FTimerHandle HideAnnoucementTextTimerHandle;
+
+    // Difference between the client and the server clocks
+    float ClientServerDelta = 0.f;
+
+    // Half of the last measured round trip time
+    float SingleTripTime = 0.f;
+
+    // How often we re-sync with the server clock (seconds)
+    UPROPERTY(EditAnywhere, Category = "Time")
+    float TimeSyncFrequency = 5.f;
+
+    float TimeSyncRunningTime = 0.f;
+
+    void CheckTimeSync(float DeltaSeconds);
 };
@@ -0,0 +1,54 @@
+// Copyright (c) 2024 Rasna Studios. All rights reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+// The state of a simulated proxy when an update was received
+struct FProxySnapshot
+{
+    float Time = 0.f;    // world time of arrival
+    float Yaw = 0.f;
+    float Pitch = 0.f;    // aim offset pitch, in [-90, 90]
+    float Speed = 0.f;    // horizontal
+    bool bInAir = false;
+};
+
+/**
+ * The last updates received for a simulated proxy, sampled some time in the past so there is always a newer update to
+ * interpolate towards. Past the newest update we extrapolate for a bounded time, then hold.
+ *
+ * The snapshots are stamped with their arrival time: a proxy that stopped replicating (standing still) is idle until its next
+ * update, so when one arrives after a long gap the previous state is repeated just before it. The shorter gaps are averaged
+ * into the arrival interval, which sets how far in the past to sample (a far or hidden proxy updates less often).
+ */
+class OPENSHOOTER_API FProxySnapshotBuffer
+{
+public:
+    static constexpr int32 Capacity = 16;
+
+    // MaxGap: the longest time we interpolate over (seconds)
+    void Add(const FProxySnapshot& Snapshot, float MaxGap);
+
+    // The state at Time and its yaw rate (degrees per second, 0 once we hold). False if nothing was received yet
+    bool Sample(float Time, float MaxExtrapolation, FProxySnapshot& OutSnapshot, float& OutYawRate) const;
+
+    // Smoothed time between two updates, gaps longer than MaxGap excluded. 0 until two updates were received (seconds)
+    float GetArrivalInterval() const { return ArrivalInterval; }
+
+    void Reset()
+    {
+        Num = 0;
+        ArrivalInterval = 0.f;
+    }
+
+private:
+    FProxySnapshot Snapshots[Capacity];
+    int32 First = 0;    // oldest snapshot
+    int32 Num = 0;
+    float ArrivalInterval = 0.f;
+
+    // 0 is the oldest
+    const FProxySnapshot& Get(const int32 Index) const { return Snapshots[(First + Index) % Capacity]; }
+    void Push(const FProxySnapshot& Snapshot);
+};
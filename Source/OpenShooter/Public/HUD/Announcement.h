@@ -0,0 +1,69 @@
+// Copyright (c) 2024 Rasna Studios. All rights reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Weapon/WeaponTypes.h"
+
+#include "Announcement.generated.h"
+
+class APlayerState;
+
+// The messages the HUD can announce. Each one maps to a localized template in the announcement table
+UENUM(BlueprintType)
+enum class EAnnouncementMessage : uint8
+{
+    EAM_None UMETA(DisplayName = "None"),
+    EAM_Eliminated UMETA(DisplayName = "Eliminated"),              // {Player} killed you!
+    EAM_EliminatedWith UMETA(DisplayName = "Eliminated With"),    // {Player} killed you with the {Weapon}!
+
+    EAM_MAX UMETA(DisplayName = "DefaultMax"),
+};
+
+/**
+ * An announcement for the HUD, replicated as a message id plus its arguments instead of the formatted text.
+ *
+ * The server never builds a string: it sends 4 bits of message id, 3 bits of weapon type, a wrapping serial (so the same
+ * announcement twice in a row still triggers the OnRep) and the player state reference. The receiving client looks up the
+ * localized template for the message, compiled once and cached, and formats it with the player name it already has.
+ */
+USTRUCT()
+struct FAnnouncement
+{
+    GENERATED_BODY()
+
+    static constexpr uint32 SerialBits = 4;
+    static constexpr uint32 SerialMask = (1 << SerialBits) - 1;
+
+    // The player the message is about (the attacker for the elimination messages)
+    UPROPERTY()
+    TObjectPtr<APlayerState> Player;
+
+    EAnnouncementMessage Message = EAnnouncementMessage::EAM_None;
+
+    EWeaponType WeaponType = EWeaponType::EWT_MAX;
+
+    uint8 Serial = 0;
+
+    bool IsEmpty() const { return Message == EAnnouncementMessage::EAM_None; }
+
+    // Client: the text to show, in the rich text markup of the announcement widget
+    FText Format() const;
+
+    bool operator==(const FAnnouncement& Other) const
+    {
+        return Player == Other.Player && Message == Other.Message && WeaponType == Other.WeaponType && Serial == Other.Serial;
+    }
+
+    bool NetSerialize(FArchive& Ar, UPackageMap* Map, bool& bOutSuccess);
+};
+
+template <>
+struct TStructOpsTypeTraits<FAnnouncement> : public TStructOpsTypeTraitsBase2<FAnnouncement>
+{
+    enum
+    {
+        WithNetSerializer = true,
+        WithIdenticalViaEquality = true,    // the packed fields are not UPROPERTYs, the default comparison would miss them
+    };
+};
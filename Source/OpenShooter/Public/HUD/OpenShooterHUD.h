@@ -48,6 +48,9 @@ private:
 
     void DrawCrosshair(UTexture2D* Texture, FVector2D ViewportCenter, FVector2D Spread, FLinearColor CrosshairColor);
 
+    // The busiest lines of the bandwidth profiler, see "OpenShooter.Net.Profile.Overlay"
+    void DrawNetProfile();
+
     UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Crosshair", meta = (AllowPrivateAccess = "true"))
     float CrosshairSpreadMax = 20.f;
 
@@ -5,3 +5,6 @@
 #include "CoreMinimal.h"
 
 #define ECC_SkeletalMesh ECC_GameTraceChannel1
+
+// Stats for our own systems, shown with "stat OpenShooter"
+DECLARE_STATS_GROUP(TEXT("OpenShooter"), STATGROUP_OpenShooter, STATCAT_Advanced);
@@ -4,6 +4,7 @@
 
 #include "CoreMinimal.h"
 #include "GameFramework/PlayerState.h"
+#include "HUD/Announcement.h"
 
 #include "OpenShooterPlayerState.generated.h"
 
@@ -45,8 +46,12 @@ private:
     UPROPERTY(ReplicatedUsing = OnRep_Defeats)
     int32 Defeats;
 
+    // Only the message id and its arguments are replicated, the owning client formats the text (see FAnnouncement)
     UPROPERTY(ReplicatedUsing = OnRep_AnnounceMessage)
-    FString AnnoucementMessage;
+    FAnnouncement Annoucement;
+
+    // Shows the current announcement on the HUD of the local controller, if any
+    void ShowAnnoucement();
 
 public:
     // Client function to update the score. We override this function to update the HUD in the client (the base one is empty)
@@ -67,6 +72,6 @@ public:
     void OnRep_AnnounceMessage();
 
     // Server function to show the annoucement message for listen-server player
-    void SetAnnoucementMessage(const FString& Message);
+    void SetAnnoucementMessage(EAnnouncementMessage Message, APlayerState* Player, EWeaponType WeaponType = EWeaponType::EWT_MAX);
     void ClearAnnoucementMessage();
 };
@@ -0,0 +1,50 @@
+// Copyright (c) 2024 Rasna Studios. All rights reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Serialization/BitWriter.h"
+#include "UObject/CoreNet.h"
+
+#include "NetBitCounter.generated.h"
+
+/**
+ * The package map of FNetBitCounter: an object reference is written as a NetGUID, packed. Nothing is looked up or exported.
+ */
+UCLASS(Transient)
+class OPENSHOOTER_API UNetBitCounterPackageMap : public UPackageMap
+{
+    GENERATED_BODY()
+
+public:
+    virtual bool SerializeObject(FArchive& Ar, UClass* InClass, UObject*& Obj, FNetworkGUID* OutNetGUID = nullptr) override;
+};
+
+/**
+ * Measures what a net serialized struct costs by serializing a copy into a bit writer of our own.
+ *
+ * NetSerialize only gets an FArchive, which we cannot safely cast back to whatever writer or reader the engine passed, so the
+ * stats and the bandwidth profiler size the compact structs with this instead. The references count as a NetGUID: the path
+ * exported with the first reference to an object is not included.
+ */
+struct OPENSHOOTER_API FNetBitCounter
+{
+    template <typename T>
+    static int64 Count(const T& Value)
+    {
+        TGuardValue<bool> CountingGuard(bCounting, true);
+        T Copy = Value;
+        FBitWriter Writer(0, true);
+        bool bSuccess = true;
+        Copy.NetSerialize(Writer, GetPackageMap(), bSuccess);
+        return Writer.GetNumBits();
+    }
+
+    // The NetSerialize being called is the one of a copy being counted
+    static bool IsCounting() { return bCounting; }
+
+private:
+    static UPackageMap* GetPackageMap();
+
+    static bool bCounting;
+};
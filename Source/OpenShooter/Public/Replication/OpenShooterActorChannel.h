@@ -0,0 +1,26 @@
+// Copyright (c) 2024 Rasna Studios. All rights reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Engine/ActorChannel.h"
+
+#include "OpenShooterActorChannel.generated.h"
+
+/**
+ * The actor channel of every net driver (see ChannelDefinitions in DefaultEngine.ini). It only measures the bunches it sends
+ * and receives for the bandwidth profiler (UNetProfilerSubsystem), the replication itself is left to the engine.
+ */
+UCLASS(transient)
+class OPENSHOOTER_API UOpenShooterActorChannel : public UActorChannel
+{
+    GENERATED_BODY()
+
+public:
+    UOpenShooterActorChannel(const FObjectInitializer& ObjectInitializer = FObjectInitializer::Get());
+
+    virtual FPacketIdRange SendBunch(FOutBunch* Bunch, bool Merge) override;
+
+protected:
+    virtual void ReceivedBunch(FInBunch& Bunch) override;
+};
@@ -0,0 +1,182 @@
+// Copyright (c) 2024 Rasna Studios. All rights reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "ReplicationGraph.h"
+
+#include "OpenShooterReplicationGraph.generated.h"
+
+class AOpenShooterCharacter;
+class UReplicationGraphNode_ActorList;
+class UReplicationGraphNode_GridSpatialization2D;
+
+// How the actors of a class are routed to the graph nodes
+enum class EClassRepNodeMapping : uint8
+{
+    NotRouted,                 // not in any global node (e.g. the player controllers, gathered per connection)
+    RelevantAllConnections,    // always relevant to everyone (game state, player states)
+    Spatialize_Dynamic,        // grid node, moves every frame (characters, projectiles)
+    Spatialize_Dormancy,       // grid node, static while dormant (weapons)
+};
+
+/**
+ * Replication graph for OpenShooter, used instead of the default per-actor relevancy checks.
+ *
+ * Characters and projectiles go in a 2D spatial grid, so each connection only considers the cells around its viewer. Weapons go
+ * in the same grid through its dormancy path: a dropped weapon that went dormant costs nothing until it wakes up. Each
+ * connection also has a node that always replicates its controller, pawn, player state and equipped weapon.
+ *
+ * Characters replicate at an adaptive rate per connection: the character lowers its own rate when idle, and the graph lowers it
+ * further for the connections that are far away or can't see it (UOpenShooterReplicationGraphNode_AdaptiveRate). The bits sent
+ * per class (characters, projectiles, weapons) are reported to the CSV profiler, in the ReplicationGraph category.
+ *
+ * Enabled and tuned from DefaultEngine.ini (ReplicationDriverClassName on the net drivers, and the section of this class).
+ */
+UCLASS(Transient, Config = Engine)
+class OPENSHOOTER_API UOpenShooterReplicationGraph : public UReplicationGraph
+{
+    GENERATED_BODY()
+
+public:
+    virtual void InitGlobalActorClassSettings() override;
+    virtual void InitGlobalGraphNodes() override;
+    virtual void InitConnectionGraphNodes(UNetReplicationGraphConnection* RepGraphConnection) override;
+    virtual void RouteAddNetworkActorToNodes(
+        const FNewReplicatedActorInfo& ActorInfo, FGlobalActorReplicationInfo& GlobalInfo) override;
+    virtual void RouteRemoveNetworkActorToNodes(const FNewReplicatedActorInfo& ActorInfo) override;
+
+    // The rate at which a character replicates to a viewer: its own rate (lower when idle), scaled down with the distance and
+    // when the viewer can't see it, never below CharacterMinNetRate
+    float GetCharacterNetRate(const AOpenShooterCharacter* Character, float Distance, bool bVisible) const;
+
+    FORCEINLINE const TArray<AOpenShooterCharacter*>& GetCharacters() const { return Characters; }
+    FORCEINLINE float GetNearDistance() const { return NearDistance; }
+    FORCEINLINE float GetVisibilityCheckInterval() const { return VisibilityCheckInterval; }
+    FORCEINLINE int32 GetMaxCharactersPerFrame() const { return MaxCharactersPerFrame; }
+
+    // Takes a line of sight trace from the budget shared by all the connections. False once the budget of this replication
+    // frame is spent
+    bool ConsumeVisibilityTrace(uint32 ReplicationFrameNum);
+
+private:
+    EClassRepNodeMapping GetMappingPolicy(UClass* Class);
+    void InitClassReplicationInfo(UClass* Class, bool bSpatialize);
+
+    TClassMap<EClassRepNodeMapping> ClassRepNodePolicies;
+
+    UPROPERTY()
+    TObjectPtr<UReplicationGraphNode_GridSpatialization2D> GridNode;
+
+    UPROPERTY()
+    TObjectPtr<UReplicationGraphNode_ActorList> AlwaysRelevantNode;
+
+    // Size of a grid cell (cm)
+    UPROPERTY(Config)
+    float GridCellSize = 10000.f;
+
+    // Lowest corner of the map, so the grid does not need negative cells
+    UPROPERTY(Config)
+    float SpatialBiasX = -150000.f;
+
+    UPROPERTY(Config)
+    float SpatialBiasY = -200000.f;
+
+    // Don't rebuild the grid when an actor leaves it, just let it go (cheaper for big maps)
+    UPROPERTY(Config)
+    bool bDisableSpatialRebuilding = true;
+
+    // Every replicated character, for the adaptive rate nodes
+    UPROPERTY()
+    TArray<AOpenShooterCharacter*> Characters;
+
+    // = Adaptive character rate =
+
+    UPROPERTY(Config)
+    float CharacterMinNetRate = 5.f;
+
+    // Full rate up to NearDistance, then down to FarRateScale at FarDistance (cm)
+    UPROPERTY(Config)
+    float NearDistance = 2000.f;
+
+    UPROPERTY(Config)
+    float FarDistance = 10000.f;
+
+    UPROPERTY(Config)
+    float FarRateScale = 0.25f;
+
+    // Applied when the viewer has no line of sight to the character
+    UPROPERTY(Config)
+    float HiddenRateScale = 0.5f;
+
+    // How often the line of sight of a viewer to a character is checked again (seconds)
+    UPROPERTY(Config)
+    float VisibilityCheckInterval = 0.25f;
+
+    // Line of sight traces per replication frame, for all the connections. The others keep their last result
+    UPROPERTY(Config)
+    int32 MaxVisibilityTracesPerFrame = 16;
+
+    // Characters whose rate each connection updates per replication frame, the walk over all of them is spread over frames
+    UPROPERTY(Config)
+    int32 MaxCharactersPerFrame = 8;
+
+    int32 VisibilityTracesLeft = 0;
+    uint32 VisibilityTraceFrame = 0;
+};
+
+// Per connection: the actors that are always relevant to their owner
+UCLASS()
+class OPENSHOOTER_API UOpenShooterReplicationGraphNode_OwnerRelevant : public UReplicationGraphNode
+{
+    GENERATED_BODY()
+
+public:
+    virtual void NotifyAddNetworkActor(const FNewReplicatedActorInfo& ActorInfo) override {}
+    virtual bool NotifyRemoveNetworkActor(const FNewReplicatedActorInfo& ActorInfo, bool bWarnIfNotFound = true) override
+    {
+        return false;
+    }
+    virtual void NotifyResetAllNetworkActors() override {}
+
+    virtual void GatherActorListsForConnection(const FConnectionGatherActorListParameters& Params) override;
+
+private:
+    FActorRepListRefView ReplicationActorList;
+};
+
+// Per connection: sets the replication period of every character for this connection (see GetCharacterNetRate). It does not
+// gather any actor, the characters are gathered by the grid
+UCLASS()
+class OPENSHOOTER_API UOpenShooterReplicationGraphNode_AdaptiveRate : public UReplicationGraphNode
+{
+    GENERATED_BODY()
+
+public:
+    virtual void NotifyAddNetworkActor(const FNewReplicatedActorInfo& ActorInfo) override {}
+    virtual bool NotifyRemoveNetworkActor(const FNewReplicatedActorInfo& ActorInfo, bool bWarnIfNotFound = true) override
+    {
+        return false;
+    }
+    virtual void NotifyResetAllNetworkActors() override {}
+
+    virtual void GatherActorListsForConnection(const FConnectionGatherActorListParameters& Params) override;
+
+    UPROPERTY()
+    TObjectPtr<UOpenShooterReplicationGraph> Graph;
+
+private:
+    // Last line of sight result of this connection's viewer to a character
+    struct FVisibility
+    {
+        bool bVisible = true;
+        float NextCheckTime = 0.f;
+    };
+
+    TMap<TWeakObjectPtr<const AOpenShooterCharacter>, FVisibility> Visibility;
+
+    // Where the walk over the characters resumes next frame
+    int32 NextCharacter = 0;
+
+    bool IsVisible(const AOpenShooterCharacter* Character, const FNetViewer& Viewer, uint32 ReplicationFrameNum);
+};
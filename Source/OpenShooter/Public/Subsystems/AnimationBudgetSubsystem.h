@@ -0,0 +1,72 @@
+// Copyright (c) 2024 Rasna Studios. All rights reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+
+#include "AnimationBudgetSubsystem.generated.h"
+
+class AOpenShooterCharacter;
+class USkeletalMeshComponentBudgeted;
+
+/**
+ * Puts the meshes of the simulated proxies under the Animation Budget Allocator, so the animation of the other players fits in a
+ * fixed game thread budget (BudgetMs) however many of them are on screen.
+ *
+ * Every frame we give each proxy mesh the significance of its character (see UCharacterSignificanceSubsystem, the value may be
+ * a frame old). The allocator ticks the least significant meshes at a reduced rate (interpolating in between) and skips the
+ * off-screen ones. Below ReducedDetailSignificance, or when the allocator asks for reduced work, the anim instance also drops
+ * the left hand IK and the right hand look-at.
+ *
+ * The locally controlled character and the characters of a server are never budgeted: their pose drives the camera, the weapon
+ * and the hitboxes.
+ */
+UCLASS(config = Game)
+class OPENSHOOTER_API UAnimationBudgetSubsystem : public UWorldSubsystem
+{
+    GENERATED_BODY()
+
+public:
+    virtual bool ShouldCreateSubsystem(UObject* Outer) const override;
+    virtual void OnWorldBeginPlay(UWorld& InWorld) override;
+    virtual void Initialize(FSubsystemCollectionBase& Collection) override;
+    virtual void Deinitialize() override;
+
+    void Register(AOpenShooterCharacter* Character);
+    void Unregister(AOpenShooterCharacter* Character);
+
+private:
+    struct FBudgetedCharacter
+    {
+        TWeakObjectPtr<AOpenShooterCharacter> Character;
+        bool bBudgeted = false;      // registered with the allocator
+        bool bReducedWork = false;    // the allocator asked for less work
+        int32 SignificanceIndex = INDEX_NONE;    // where UCharacterSignificanceSubsystem keeps the character
+    };
+
+    TArray<FBudgetedCharacter> Characters;
+
+    FDelegateHandle PostActorTickHandle;
+
+    // After every actor ticked: counts the meshes the allocator throttled this frame and sets the significances for the next one
+    void OnWorldPostActorTick(UWorld* World, ELevelTick TickType, float DeltaSeconds);
+
+    void SetBudgeted(FBudgetedCharacter& Entry, USkeletalMeshComponentBudgeted* Mesh, bool bBudgeted);
+
+    void OnReduceWork(USkeletalMeshComponentBudgeted* Mesh, bool bReduceWork);
+
+    int32 FindIndex(const AOpenShooterCharacter* Character) const;
+
+    // Game thread time the animation of all the budgeted meshes should fit in (ms)
+    UPROPERTY(Config)
+    float BudgetMs = 1.f;
+
+    // The slowest a budgeted mesh can tick, in frames between two updates
+    UPROPERTY(Config)
+    int32 MaxTickRate = 10;
+
+    // Below this significance the left hand IK and the right hand look-at are skipped
+    UPROPERTY(Config)
+    float ReducedDetailSignificance = 0.3f;
+};
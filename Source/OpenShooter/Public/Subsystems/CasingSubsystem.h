@@ -0,0 +1,111 @@
+// Copyright (c) 2024 Rasna Studios. All rights reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+
+#include "CasingSubsystem.generated.h"
+
+class ACasing;
+class UInstancedStaticMeshComponent;
+class USoundCue;
+
+// Everything the casings of one ACasing class share: the instanced mesh that renders them and the data from the class defaults
+USTRUCT()
+struct FCasingType
+{
+    GENERATED_BODY()
+
+    UPROPERTY()
+    TObjectPtr<UInstancedStaticMeshComponent> Instances;
+
+    UPROPERTY()
+    TObjectPtr<USoundCue> ShellSound;
+
+    float EjectionImpulse = 0.f;
+    FVector Scale = FVector::OneVector;
+
+    // Instances not used by any casing (hidden with a zero scale). We never remove instances, so the indices stay valid
+    TArray<int32> FreeInstances;
+};
+
+/**
+ * Cosmetic shell casings, without actors and without physics bodies.
+ *
+ * Every casing class is rendered with one instanced static mesh, and the casings are simulated here: a ballistic arc, a line
+ * trace to bounce on the ground and a simple spin. The simulation data is a fixed-size structure of arrays, used as a ring buffer:
+ * when MaxCasings are alive, the oldest casing is recycled for the new one. As with the ACasing actor, each casing plays its
+ * sound only on the first impact and disappears a couple of seconds after landing.
+ *
+ * Nothing is simulated on a dedicated server.
+ */
+UCLASS()
+class OPENSHOOTER_API UCasingSubsystem : public UTickableWorldSubsystem
+{
+    GENERATED_BODY()
+
+public:
+    virtual void Initialize(FSubsystemCollectionBase& Collection) override;
+    virtual void Deinitialize() override;
+
+    virtual void Tick(float DeltaTime) override;
+    virtual TStatId GetStatId() const override;
+    virtual bool IsTickable() const override { return NumAlive > 0; }
+
+    // Ejects a casing of the given class from the transform (usually the AmmoEject socket of the weapon)
+    void EjectCasing(TSubclassOf<ACasing> CasingClass, const FTransform& EjectTransform);
+
+private:
+    int32 FindOrAddCasingType(TSubclassOf<ACasing> CasingClass);
+    void FreeSlot(int32 Slot);
+
+    // Actor that owns the instanced mesh components
+    UPROPERTY()
+    TObjectPtr<AActor> InstancesOwner;
+
+    UPROPERTY()
+    TArray<FCasingType> CasingTypes;
+
+    UPROPERTY()
+    TMap<TSubclassOf<ACasing>, int32> CasingTypeIndices;
+
+    // = Simulation (SoA ring buffer) =
+
+    enum ECasingFlags : uint8
+    {
+        Alive = 1 << 0,
+        Resting = 1 << 1,
+        PlayedSound = 1 << 2,
+    };
+
+    TArray<FVector> Positions;
+    TArray<FVector> Velocities;
+    TArray<FQuat> Rotations;
+    TArray<FVector> AngularVelocities;    // axis * radians per second
+    TArray<float> Lifetimes;              // seconds left before the casing disappears
+    TArray<int32> Types;                  // index in CasingTypes
+    TArray<int32> InstanceIndices;        // index of the instance in the type's instanced mesh
+    TArray<uint8> Flags;
+
+    int32 NextSlot = 0;
+    int32 NumAlive = 0;
+
+    // Hard cap for all the casings in the world. Past this, the oldest casing is recycled
+    int32 MaxCasings = 256;
+
+    // Seconds a casing stays around after its first impact (matches the old ACasing life span)
+    float LifetimeAfterImpact = 2.f;
+
+    // Seconds a casing can fly without touching anything
+    float MaxFlightTime = 5.f;
+
+    // Fraction of the normal velocity kept after a bounce
+    float Restitution = 0.3f;
+
+    // Fraction of the tangential velocity kept after a bounce
+    float Friction = 0.6f;
+
+    // Below this speed after a bounce the casing stops moving
+    float RestSpeed = 20.f;
+};
@@ -0,0 +1,100 @@
+// Copyright (c) 2024 Rasna Studios. All rights reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+
+#include "CharacterSignificanceSubsystem.generated.h"
+
+class AOpenShooterCharacter;
+class UActorComponent;
+
+/**
+ * Computes the significance of every character once per frame, and lowers with it the tick rate of what the characters tick
+ * for nothing. The animation budget reads the same significance (see UAnimationBudgetSubsystem).
+ *
+ * The locally controlled character is fully significant. The others get a significance from their distance to the camera and
+ * whether they were rendered recently. With it we set the tick interval of:
+ *  - the character (aim pitch and hit reacts of the proxies, PollInit, HideCameraIfCharacterClose),
+ *  - the overhead widget, disabled when not significant at all,
+ *  - the dissolve timeline while it plays.
+ * The combat component only works for the locally controlled character, its tick is disabled on every other one.
+ *
+ * A server keeps ticking its characters every frame: their aim pitch feeds the hitboxes and their tick sets their net update
+ * frequency. A dedicated server disables the overhead widget and the dissolve timeline: nobody sees them.
+ *
+ * "stat OpenShooter" shows the ticks saved per frame. "OpenShooter.Significance 0" restores every tick, the significance is
+ * still computed.
+ */
+UCLASS(config = Game)
+class OPENSHOOTER_API UCharacterSignificanceSubsystem : public UWorldSubsystem
+{
+    GENERATED_BODY()
+
+public:
+    virtual void Initialize(FSubsystemCollectionBase& Collection) override;
+    virtual void Deinitialize() override;
+
+    void Register(AOpenShooterCharacter* Character);
+    void Unregister(AOpenShooterCharacter* Character);
+
+    // From 0 (far or hidden) to 1 (locally controlled, or close and rendered). 1 for a character that is not registered
+    float GetSignificance(const AOpenShooterCharacter* Character) const;
+
+    // Same, for a caller reading every character each frame. InOutIndex caches where the character is: it is only searched
+    // again when the entries moved (INDEX_NONE the first time)
+    float GetSignificance(const AOpenShooterCharacter* Character, int32& InOutIndex) const;
+
+private:
+    struct FCharacterSignificance
+    {
+        TWeakObjectPtr<AOpenShooterCharacter> Character;
+        float Significance = 1.f;
+    };
+
+    TArray<FCharacterSignificance> Characters;
+
+    FDelegateHandle PostActorTickHandle;
+
+    // After every actor ticked: computes the significances, sets the tick intervals for the next frames and counts the ticks
+    // saved this frame
+    void OnWorldPostActorTick(UWorld* World, ELevelTick TickType, float DeltaSeconds);
+
+    float CalculateSignificance(const AOpenShooterCharacter* Character, const FVector* ViewLocation) const;
+
+    int32 FindIndex(const AOpenShooterCharacter* Character) const;
+
+    // Character tick interval for a significance, 0 for every frame
+    float GetTickInterval(float Significance) const;
+
+    // Applies the tick state when it changed and returns the ticks it saves this frame (1 when disabled)
+    static float SetActorTick(AActor* Actor, float Interval, float DeltaSeconds);
+    static float SetComponentTick(UActorComponent* Component, bool bEnabled, float Interval, float DeltaSeconds);
+
+    // Beyond this distance from the camera a character has no significance (cm)
+    UPROPERTY(Config)
+    float SignificanceMaxDistance = 8000.f;
+
+    // Significance multiplier for the characters that were not rendered recently
+    UPROPERTY(Config)
+    float HiddenSignificanceScale = 0.25f;
+
+    // Above this significance everything ticks every frame
+    UPROPERTY(Config)
+    float HighSignificance = 0.6f;
+
+    // Between LowSignificance and HighSignificance the ticks run at MediumTickInterval, below at LowTickInterval (seconds)
+    UPROPERTY(Config)
+    float LowSignificance = 0.2f;
+
+    UPROPERTY(Config)
+    float MediumTickInterval = 0.033f;
+
+    UPROPERTY(Config)
+    float LowTickInterval = 0.1f;
+
+    // The overhead widget only shows a name, it never needs to redraw faster than this (seconds)
+    UPROPERTY(Config)
+    float OverHeadWidgetTickInterval = 0.1f;
+};
@@ -0,0 +1,53 @@
+// Copyright (c) 2024 Rasna Studios. All rights reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "Weapon/ImpactBatch.h"
+
+#include "ImpactEventSubsystem.generated.h"
+
+/**
+ * Collects the impacts of a server frame and sends them to each connection as a single unreliable RPC, instead of one multicast
+ * per impact (a shotgun blast alone is a dozen of them).
+ *
+ * At the end of the frame, every player controller gets the impacts close enough to its view point in one FImpactBatch, and
+ * its client plays the whole batch with PlayImpacts. On a listen server the local player plays them the same way.
+ */
+UCLASS()
+class OPENSHOOTER_API UImpactEventSubsystem : public UWorldSubsystem
+{
+    GENERATED_BODY()
+
+public:
+    virtual void Initialize(FSubsystemCollectionBase& Collection) override;
+    virtual void Deinitialize() override;
+
+    // Server. Source is the class whose defaults have the effects: the victim's class if bVictim, the projectile's otherwise
+    void AddImpact(const FVector& Location, const FRotator& Rotation, uint8 SurfaceType, bool bVictim, UClass* Source);
+
+    // Client. Plays the effects of every impact in the batch
+    void PlayImpacts(const FImpactBatch& Batch) const;
+
+private:
+    struct FPendingImpact
+    {
+        FVector Location;
+        FRotator Rotation;
+        uint8 SurfaceType;
+        bool bVictim;
+        UClass* Source;
+    };
+
+    TArray<FPendingImpact> PendingImpacts;
+
+    FDelegateHandle PostActorTickHandle;
+
+    // Called after every actor ticked, before the net driver sends this frame's RPCs
+    void OnWorldPostActorTick(UWorld* World, ELevelTick TickType, float DeltaSeconds);
+    void Flush();
+
+    // Impacts further than this from a connection's view point are not sent to it (cm)
+    float MaxImpactDistance = 15000.f;
+};
@@ -0,0 +1,52 @@
+// Copyright (c) 2024 Rasna Studios. All rights reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+
+#include "LagCompensationSubsystem.generated.h"
+
+class ULagCompensationComponent;
+class AOpenShooterCharacter;
+
+/**
+ * World subsystem that keeps track of every character hitbox history (ULagCompensationComponent) on the server.
+ *
+ * Weapons and projectiles use it to test a shot against the characters as they were at the time the shooter fired,
+ * instead of where they are on the server now. This is what makes shots that were on target for a high ping client register.
+ */
+UCLASS()
+class OPENSHOOTER_API ULagCompensationSubsystem : public UWorldSubsystem
+{
+    GENERATED_BODY()
+
+public:
+    void Register(ULagCompensationComponent* Component);
+    void Unregister(ULagCompensationComponent* Component);
+
+    // Traces the segment against all the rewound characters at the given server time (except IgnoredActor).
+    // OutHit is filled in like a blocking hit from a line trace. Returns true on hit.
+    bool TraceRewound(const FVector& Start, const FVector& End, float Time, const AActor* IgnoredActor, FHitResult& OutHit) const;
+
+    // Batched version of TraceRewound for many segments sharing the same start (e.g. shotgun pellets). Each character pose is
+    // rewound only once for the whole batch. OutHits has one entry per segment (bBlockingHit is false on miss).
+    // Returns the number of segments that hit a character.
+    int32 TraceRewoundBatch(const FVector& Start, TArrayView<const FVector> Ends, float Time, const AActor* IgnoredActor,
+        TArray<FHitResult>& OutHits) const;
+
+    // Clamps a client reported fire time to what we can actually rewind to
+    float ClampRewindTime(float FireTime) const;
+
+    // Called when a shot is fired along the segment. The characters close to it, the shooter included, record their real pose
+    // instead of the procedural one for as long as the shot can be rewound: the flight time plus their rewind window
+    // (dedicated server)
+    void RequestPoseSamples(const FVector& Start, const FVector& End, float FlightTime);
+
+private:
+    // Characters closer than this to the path of a shot have their pose sampled (cm)
+    float PoseSampleRadius = 1500.f;
+
+    UPROPERTY()
+    TArray<TObjectPtr<ULagCompensationComponent>> Components;
+};
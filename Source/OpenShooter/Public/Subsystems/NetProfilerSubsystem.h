@@ -0,0 +1,170 @@
+// Copyright (c) 2024 Rasna Studios. All rights reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Replication/NetBitCounter.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "UObject/ObjectKey.h"
+
+#include "NetProfilerSubsystem.generated.h"
+
+class UNetConnection;
+
+UENUM()
+enum class ENetProfileCategory : uint8
+{
+    ENPC_Actor UMETA(DisplayName = "Actor"),          // every bunch of an actor channel, by actor class
+    ENPC_RPC UMETA(DisplayName = "RPC"),              // the bunches sent while calling an RPC, by function
+    ENPC_Property UMETA(DisplayName = "Property"),    // the bits of an instrumented NetSerialize, by property
+
+    ENPC_MAX UMETA(DisplayName = "DefaultMax"),
+};
+
+// One line of the report: the traffic of one actor class, RPC or property on one connection
+struct FNetProfileRow
+{
+    ENetProfileCategory Category = ENetProfileCategory::ENPC_Actor;
+    FName Name;
+    FString Connection;
+    bool bSent = true;
+
+    // Last complete second
+    int64 Bytes1s = 0;
+    int32 Count1s = 0;
+
+    // Last 60 complete seconds
+    int64 Bytes60s = 0;
+    int32 Count60s = 0;
+};
+
+/**
+ * Bandwidth profiler: bytes and counts per actor class, RPC and property, per connection and direction, over rolling windows of
+ * 1 and 60 seconds.
+ *
+ * It is fed by the OpenShooter actor channel (every bunch sent or received, and the RPC being called while it is sent, see
+ * FNetProfileRPCScope) and by the NetSerialize of the compact replicated structs (see FNetProfilePropertyScope). Unreliable
+ * multicasts are queued by the engine and sent with the next bunch of the actor: they are counted with their RPC but their bytes
+ * show up in the actor class.
+ *
+ * The property lines only cover the structs that open a FNetProfilePropertyScope (HealthState, CombatRepState and
+ * Announcement). The other replicated properties are only counted with the bunches of their actor class.
+ *
+ * Nothing is recorded unless "OpenShooter.Net.Profile 1". Then:
+ *  - "OpenShooter.Net.Profile.Print [Filter]" prints the report,
+ *  - "OpenShooter.Net.Profile.Csv" writes it to Saved/Profiling/NetProfile,
+ *  - "OpenShooter.Net.Profile.Overlay N" draws the N busiest lines on the HUD,
+ *  - "OpenShooter.Net.Profile.Reset" clears everything.
+ */
+UCLASS()
+class OPENSHOOTER_API UNetProfilerSubsystem : public UWorldSubsystem
+{
+    GENERATED_BODY()
+
+public:
+    static bool IsEnabled();
+
+    // Number of lines drawn on the HUD, 0 when the overlay is off
+    static int32 GetOverlayLines();
+
+    // The profiler of the world the connection belongs to, nullptr if profiling is disabled
+    static UNetProfilerSubsystem* Get(const UNetConnection* Connection);
+
+    void Record(ENetProfileCategory Category, FName Name, UNetConnection* Connection, bool bSent, int64 Bits);
+
+    // Rows sorted by bytes over the last second, then over the last minute. Rows with nothing in the last minute are skipped
+    void GetRows(TArray<FNetProfileRow>& OutRows, const FString& Filter = FString()) const;
+
+    void LogReport(const FString& Filter) const;
+
+    // Returns the path of the written file, or an empty string on failure
+    FString WriteCsv() const;
+
+    void Reset();
+
+    static constexpr int32 WindowSeconds = 60;
+
+private:
+    struct FKey
+    {
+        ENetProfileCategory Category;
+        FName Name;
+        TObjectKey<UNetConnection> Connection;
+        bool bSent;
+
+        bool operator==(const FKey& Other) const
+        {
+            return Category == Other.Category && Name == Other.Name && Connection == Other.Connection && bSent == Other.bSent;
+        }
+
+        friend uint32 GetTypeHash(const FKey& Key)
+        {
+            return HashCombine(HashCombine(GetTypeHash(Key.Name), GetTypeHash(Key.Connection)),
+                static_cast<uint32>(Key.Category) << 1 | (Key.bSent ? 1u : 0u));
+        }
+    };
+
+    // One bucket per second, indexed by Second % WindowSeconds
+    struct FEntry
+    {
+        FString Connection;
+        int64 LastSecond = 0;
+        int64 Bits[WindowSeconds] = {};
+        int32 Counts[WindowSeconds] = {};
+
+        // Clears the buckets of the seconds elapsed since LastSecond
+        void Advance(int64 Second);
+    };
+
+    TMap<FKey, FEntry> Entries;
+
+    static int64 GetSecond();
+    static FString GetConnectionName(UNetConnection* Connection);
+};
+
+// Records the bunches sent while an RPC is being called as traffic of that RPC (game thread only, see CallRemoteFunction)
+struct OPENSHOOTER_API FNetProfileRPCScope
+{
+    FNetProfileRPCScope(const UObject* InObject, const UFunction* InFunction);
+    ~FNetProfileRPCScope();
+
+    // The RPC being called, None outside of a scope
+    static FName GetCurrent() { return Current; }
+
+    // Called by the actor channel when it sends a bunch of the current RPC
+    static void MarkSent() { bSent = true; }
+
+private:
+    const UObject* Object = nullptr;
+    const UFunction* Function = nullptr;
+    FName Previous;
+    bool bPreviousSent = false;
+
+    static FName Current;
+    static bool bSent;
+};
+
+// Records the bits of the value read or written by a NetSerialize function as traffic of a property, once the value is
+// complete. The archive is left alone: the value is sized again with FNetBitCounter. Only net archives are measured
+struct OPENSHOOTER_API FNetProfilePropertyScope
+{
+    template <typename T>
+    FNetProfilePropertyScope(const TCHAR* InName, const T& InValue, FArchive& Ar, UPackageMap* Map)
+        : FNetProfilePropertyScope(InName, Ar, Map)
+    {
+        Value = &InValue;
+        CountBits = [](const void* Counted) { return FNetBitCounter::Count(*static_cast<const T*>(Counted)); };
+    }
+
+    ~FNetProfilePropertyScope();
+
+private:
+    FNetProfilePropertyScope(const TCHAR* InName, FArchive& Ar, UPackageMap* Map);
+
+    const TCHAR* Name;
+    bool bSent = true;
+    UNetConnection* Connection = nullptr;
+    UNetProfilerSubsystem* Profiler = nullptr;
+    const void* Value = nullptr;
+    int64 (*CountBits)(const void*) = nullptr;
+};
@@ -0,0 +1,75 @@
+// Copyright (c) 2024 Rasna Studios. All rights reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+
+#include "ProjectilePoolSubsystem.generated.h"
+
+class AProjectile;
+
+// Pool usage counters for one projectile class
+USTRUCT()
+struct FProjectilePoolStats
+{
+    GENERATED_BODY()
+
+    int32 Hits = 0;          // acquires served from the pool
+    int32 Misses = 0;        // acquires that had to spawn a new projectile
+    int32 Prewarmed = 0;     // projectiles spawned ahead of time
+    int32 Destroyed = 0;     // projectiles released while the pool was full
+    int32 InFlight = 0;      // projectiles currently launched
+};
+
+// The projectiles of one class waiting to be launched
+USTRUCT()
+struct FProjectilePool
+{
+    GENERATED_BODY()
+
+    UPROPERTY()
+    TArray<TObjectPtr<AProjectile>> Free;
+
+    FProjectilePoolStats Stats;
+};
+
+/**
+ * Pool of projectiles, one pool per projectile class. The server pools the projectiles it launches, and the clients the cosmetic
+ * copies of the client simulated ones.
+ *
+ * Spawning a replicated actor for every round means a new UObject, a new actor channel on every connection and garbage to collect
+ * when it is destroyed. Instead, the weapons pre-warm a number of projectiles at BeginPlay and every shot launches one of them.
+ * When a projectile hits something or times out it is retired (hidden, stopped and dormant) and goes back to the pool.
+ *
+ * Use "OpenShooter.ProjectilePool.Stats" in the console to print the hit/miss counters.
+ */
+UCLASS()
+class OPENSHOOTER_API UProjectilePoolSubsystem : public UWorldSubsystem
+{
+    GENERATED_BODY()
+
+public:
+    // Makes sure at least Count projectiles of this class are waiting in the pool
+    void Prewarm(TSubclassOf<AProjectile> ProjectileClass, int32 Count);
+
+    // Launches a projectile from the pool (or a new one if the pool is empty)
+    AProjectile* Acquire(
+        TSubclassOf<AProjectile> ProjectileClass, const FTransform& SpawnTransform, AActor* Owner, APawn* Instigator);
+
+    // Retires the projectile and puts it back in its pool
+    void Release(AProjectile* Projectile);
+
+    void LogStats() const;
+
+    FORCEINLINE const TMap<TSubclassOf<AProjectile>, FProjectilePool>& GetPools() const { return Pools; }
+
+private:
+    AProjectile* SpawnPooledProjectile(TSubclassOf<AProjectile> ProjectileClass) const;
+
+    UPROPERTY()
+    TMap<TSubclassOf<AProjectile>, FProjectilePool> Pools;
+
+    // Released projectiles above this number (per class) are destroyed instead of pooled
+    int32 MaxPooledPerClass = 128;
+};
@@ -9,6 +9,8 @@
 
 class USoundCue;
 
+// Describes a shell casing: mesh, ejection impulse and impact sound. Weapons eject casings through UCasingSubsystem, which reads
+// these from the class defaults and simulates them without spawning the actor
 UCLASS()
 class OPENSHOOTER_API ACasing : public AActor
 {
@@ -38,4 +40,7 @@ private:
 
 public:
     FORCEINLINE UStaticMesh* GetMesh() const { return CasingMesh->GetStaticMesh(); }
+    FORCEINLINE UStaticMeshComponent* GetMeshComponent() const { return CasingMesh; }
+    FORCEINLINE float GetShellEjectionImpulse() const { return ShellEjectionImpulse; }
+    FORCEINLINE USoundCue* GetShellSound() const { return ShellSound; }
 };
@@ -0,0 +1,61 @@
+// Copyright (c) 2024 Rasna Studios. All rights reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Engine/NetSerialization.h"
+
+#include "FireBatch.generated.h"
+
+/**
+ * The shots a client fired during one frame, sent to the server (and from the server to the other clients) as a single RPC.
+ *
+ * Targets are delta-encoded: the first one is sent relative to the origin and each of the others relative to the previous one,
+ * so an automatic weapon hammering the same spot costs a few bits per shot. Fire times are sent as the first server time plus
+ * millisecond deltas, and the fire sequences as the sequence of the first shot.
+ */
+USTRUCT()
+struct FFireBatch
+{
+    GENERATED_BODY()
+
+    static constexpr int32 MaxShots = 16;
+
+    TArray<FVector_NetQuantize, TInlineAllocator<4>> Targets;
+    TArray<float, TInlineAllocator<4>> FireTimes;
+
+    // Fire sequence of the first shot, the others follow in order
+    uint16 FirstSequence = 0;
+
+    void Add(const FVector_NetQuantize& Target, const float FireTime, const uint16 FireSequence)
+    {
+        if (Targets.Num() == 0)
+            FirstSequence = FireSequence;
+        Targets.Add(Target);
+        FireTimes.Add(FireTime);
+    }
+
+    int32 Num() const { return Targets.Num(); }
+    uint16 GetSequence(const int32 Index) const { return static_cast<uint16>(FirstSequence + Index); }
+    bool IsFull() const { return Targets.Num() >= MaxShots; }
+
+    void Reset()
+    {
+        Targets.Reset();
+        FireTimes.Reset();
+    }
+
+    bool NetSerialize(FArchive& Ar, UPackageMap* Map, bool& bOutSuccess);
+
+    // Counts the batch in the stats, once per RPC call ("stat OpenShooter")
+    void RecordSent() const;
+};
+
+template <>
+struct TStructOpsTypeTraits<FFireBatch> : public TStructOpsTypeTraitsBase2<FFireBatch>
+{
+    enum
+    {
+        WithNetSerializer = true,
+    };
+};
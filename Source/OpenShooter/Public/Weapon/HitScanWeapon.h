@@ -0,0 +1,80 @@
+// Copyright (c) 2024 Rasna Studios. All rights reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Weapon/Weapon.h"
+
+#include "HitScanWeapon.generated.h"
+
+class UParticleSystem;
+class USoundCue;
+
+// Result of a hitscan shot: one impact point per pellet and two bit masks (max 32 pellets)
+struct FHitScanResult
+{
+    TArray<FVector, TInlineAllocator<32>> ImpactPoints;
+
+    // Bit i is set if pellet i hit something (otherwise the impact point is just the end of the trace)
+    uint32 BlockingHitMask = 0;
+
+    // Bit i is set if pellet i hit a character
+    uint32 CharacterHitMask = 0;
+};
+
+/**
+ * A weapon that resolves its shots instantly with line traces on the server, instead of spawning a replicated projectile.
+ *
+ * The world is traced normally, while the characters are tested against their rewound hitboxes (see ULagCompensationSubsystem).
+ * Nothing is sent to the clients: the scatter is deterministic (see AWeapon::MakeScatterStream), so every client rebuilds the
+ * same traces from the shot it received and traces them locally for the beams and impact effects.
+ *
+ * When the weapon type is EWT_Shotgun, every shot fires NumberOfPellets scattered pellets. All the pellets are resolved as one
+ * batch: the characters are rewound once for the whole shot and the damage is applied once per character.
+ */
+UCLASS()
+class OPENSHOOTER_API AHitScanWeapon : public AWeapon
+{
+    GENERATED_BODY()
+
+public:
+    virtual void Fire(const FVector& HitTarget, float FireTime, uint16 FireSequence) override;
+
+protected:
+    FORCEINLINE bool IsShotgun() const { return GetWeaponType() == EWeaponType::EWT_Shotgun; }
+
+private:
+    // Server: traces the world, rewinds the characters and applies the damage
+    void ResolveShot(const FVector& Start, TArrayView<FVector> Ends, float FireTime, FHitScanResult& OutResult) const;
+
+    // Clients: plain traces, only used for the effects
+    void TraceCosmetic(const FVector& Start, TArrayView<const FVector> Ends, FHitScanResult& OutResult) const;
+
+    void PlayHitScanEffects(const FVector& TraceStart, const FHitScanResult& Result) const;
+
+    // Damage for each pellet (or for the single trace when not a shotgun)
+    UPROPERTY(EditAnywhere, Category = "Weapon Properties|HitScan")
+    float Damage = 20.f;
+
+    // = Scatter (shotgun only) =
+
+    UPROPERTY(EditAnywhere, Category = "Weapon Properties|Scatter", meta = (ClampMin = "1", ClampMax = "32"))
+    int32 NumberOfPellets = 10;
+
+    // = Effects =
+
+    UPROPERTY(EditAnywhere, Category = "Weapon Properties|Effects")
+    TObjectPtr<UParticleSystem> BeamParticles;
+
+    UPROPERTY(EditAnywhere, Category = "Weapon Properties|Effects")
+    TObjectPtr<UParticleSystem> ImpactParticles;
+
+    UPROPERTY(EditAnywhere, Category = "Weapon Properties|Effects")
+    TObjectPtr<USoundCue> ImpactSound;
+
+    UPROPERTY(EditAnywhere, Category = "Weapon Properties|Effects")
+    TObjectPtr<UParticleSystem> CharacterImpactParticles;
+
+    UPROPERTY(EditAnywhere, Category = "Weapon Properties|Effects")
+    TObjectPtr<USoundCue> CharacterImpactSound;
+};
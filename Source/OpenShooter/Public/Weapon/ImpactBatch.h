@@ -0,0 +1,64 @@
+// Copyright (c) 2024 Rasna Studios. All rights reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Engine/NetSerialization.h"
+
+#include "ImpactBatch.generated.h"
+
+// One impact to play on the clients
+struct FImpactEvent
+{
+    FVector Location = FVector::ZeroVector;
+    FRotator Rotation = FRotator::ZeroRotator;    // only pitch and yaw are sent
+    uint8 SurfaceType = 0;                        // EPhysicalSurface
+    bool bVictim = false;                         // a character was hit (its hit effects), or the environment (the projectile's)
+    uint8 SourceIndex = 0;                        // in FImpactBatch::Sources
+};
+
+/**
+ * The impacts of one server frame that are relevant to one connection, sent as a single RPC (see UImpactEventSubsystem).
+ *
+ * The effects to play come from the class defaults of the sources: the victim's class for a character hit, the projectile's
+ * class for an environment hit. Each class is sent once per batch and the impacts refer to it with a 3-bit index.
+ * Locations are delta-encoded like in FFireBatch, since the impacts of a frame are usually close to each other (shotgun).
+ */
+USTRUCT()
+struct FImpactBatch
+{
+    GENERATED_BODY()
+
+    static constexpr int32 MaxImpacts = 32;
+    static constexpr int32 MaxSources = 8;
+
+    TArray<FImpactEvent, TInlineAllocator<8>> Impacts;
+
+    UPROPERTY()
+    TArray<TObjectPtr<UClass>> Sources;
+
+    // Returns false if the batch is full
+    bool Add(const FVector& Location, const FRotator& Rotation, uint8 SurfaceType, bool bVictim, UClass* Source);
+
+    int32 Num() const { return Impacts.Num(); }
+
+    void Reset()
+    {
+        Impacts.Reset();
+        Sources.Reset();
+    }
+
+    bool NetSerialize(FArchive& Ar, UPackageMap* Map, bool& bOutSuccess);
+
+    // Counts the batch in the stats, once per RPC call ("stat OpenShooter")
+    void RecordSent() const;
+};
+
+template <>
+struct TStructOpsTypeTraits<FImpactBatch> : public TStructOpsTypeTraitsBase2<FImpactBatch>
+{
+    enum
+    {
+        WithNetSerializer = true,
+    };
+};
@@ -12,6 +12,35 @@ class UBoxComponent;
 class UProjectileMovementComponent;
 class USoundCue;
 
+// Where and how the server launched a pooled projectile. Replicated so the clients can re-launch their copy in place
+USTRUCT()
+struct FProjectileLaunch
+{
+    GENERATED_BODY()
+
+    UPROPERTY()
+    FVector_NetQuantize Location;
+
+    UPROPERTY()
+    FVector_NetQuantizeNormal Direction;
+
+    // Changes at every launch, so the clients re-launch even if two launches happen between two net updates
+    UPROPERTY()
+    uint8 LaunchId = 0;
+
+    UPROPERTY()
+    bool bActive = false;
+};
+
+/**
+ * Projectiles are pooled (see UProjectilePoolSubsystem): instead of being spawned and destroyed for every round, the same actors
+ * are launched, retired and launched again. The server drives this through the replicated LaunchState and every machine resets
+ * the movement and the tracer in place.
+ *
+ * A client simulated projectile (bClientSimulated) is not replicated at all. The server instance does the hits, and every client
+ * launches its own cosmetic copy from the shot it already receives (see AProjectileWeapon::Fire), fast-forwarded by the time
+ * the shot took to reach it.
+ */
 UCLASS()
 class OPENSHOOTER_API AProjectile : public AActor
 {
@@ -19,8 +48,37 @@ class OPENSHOOTER_API AProjectile : public AActor
 
 public:
     AProjectile();
+    virtual void PostInitProperties() override;
+    virtual void GetLifetimeReplicatedProps(TArray<FLifetimeProperty>& OutLifetimeProps) const override;
     virtual void Tick(float DeltaTime) override;
 
+    // Server time at which the owning client fired this projectile (set by the weapon on the server)
+    virtual void SetFireTime(float InFireTime) { FireTime = InFireTime; }
+
+    // Server only. Called by the pool to fire the projectile from the given transform
+    void Launch(const FTransform& SpawnTransform);
+
+    // Server only. Stops the projectile and hides it until the next launch
+    void Retire();
+
+    // Client only. Moves a cosmetic projectile forward by the time elapsed since the shot, as if it had been launched then
+    void FastForward(float Time);
+
+    // Seconds to travel Distance in a straight line at the launch speed, at most the lifetime
+    float GetFlightTime(float Distance) const;
+
+    // Plays the impact particles (for the surface type) and sound. Also called on the class defaults (see UImpactEventSubsystem)
+    void PlayImpactEffects(UWorld* World, const FVector& Location, const FRotator& Rotation, EPhysicalSurface SurfaceType) const;
+
+    FORCEINLINE bool IsActive() const { return LaunchState.bActive; }
+    FORCEINLINE bool IsClientSimulated() const { return bClientSimulated; }
+
+    // A copy launched by a client (see bClientSimulated): it only plays the cosmetics, the server instance does the hits
+    FORCEINLINE bool IsCosmetic() const { return GetNetMode() == NM_Client && HasAuthority(); }
+
+    // The server instance, the one that hits
+    FORCEINLINE bool IsAuthoritative() const { return HasAuthority() && GetNetMode() != NM_Client; }
+
 protected:
     virtual void BeginPlay() override;
 
@@ -28,10 +86,17 @@ protected:
     virtual void OnHit(UPrimitiveComponent* HitComponent, AActor* OtherActor, UPrimitiveComponent* OtherComponent,
         FVector NormalImpulse, const FHitResult& Hit);
 
+    // Called on every machine when the projectile is (re)launched, after the movement has been reset
+    virtual void OnLaunched();
+
     // The damage that this projectile will deal (protected so child classes can access it)
     UPROPERTY(EditAnywhere, Category = "Projectile|Stats")
     float Damage = 20.f;
 
+    float FireTime = 0.f;
+
+    FORCEINLINE UBoxComponent* GetCollisionBox() const { return CollisionBox; }
+
 private:
     UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Projectile|Componenets", meta = (AllowPrivateAccess = "true"))
     TObjectPtr<UBoxComponent> CollisionBox;
@@ -48,9 +113,53 @@ private:
     UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Projectile|Effects", meta = (AllowPrivateAccess = "true"))
     TObjectPtr<UParticleSystem> ImpactParticles;
 
+    // Replaces ImpactParticles on these surfaces
+    UPROPERTY(EditAnywhere, Category = "Projectile|Effects")
+    TMap<TEnumAsByte<EPhysicalSurface>, TObjectPtr<UParticleSystem>> SurfaceImpactParticles;
+
     UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Projectile|Effects", meta = (AllowPrivateAccess = "true"))
     TObjectPtr<USoundCue> ImpactSound;
 
-    UFUNCTION(NetMulticast, Unreliable)
-    void MulticastSpawnEnvironmentHitParticles();
+    // Bound instead of OnHit on the cosmetic copies
+    UFUNCTION()
+    void OnCosmeticHit(UPrimitiveComponent* HitComponent, AActor* OtherActor, UPrimitiveComponent* OtherComponent,
+        FVector NormalImpulse, const FHitResult& Hit);
+
+    // = Replication =
+
+    // Replicate only the shot, not the projectile: the clients simulate their own copy
+    UPROPERTY(EditDefaultsOnly, Category = "Projectile|Replication")
+    bool bClientSimulated = true;
+
+    // A client does not fast-forward its copy by more than this, the rest of the delay is just lost (seconds)
+    UPROPERTY(EditDefaultsOnly, Category = "Projectile|Replication")
+    float MaxFastForwardTime = 0.3f;
+
+    // = Pooling =
+
+    UPROPERTY(ReplicatedUsing = OnRep_LaunchState)
+    FProjectileLaunch LaunchState;
+
+    UFUNCTION()
+    void OnRep_LaunchState();
+
+    // Reset the movement, collision and tracer in place (every machine)
+    void LaunchLocal();
+    void RetireLocal();
+
+    // Returns the projectile to the pool
+    void Recycle();
+
+    // Stops and hides the projectile after a hit, and recycles it a bit later
+    void StopAfterHit();
+
+    FTimerHandle RecycleTimer;
+
+    // A projectile that did not hit anything is recycled after this many seconds
+    UPROPERTY(EditAnywhere, Category = "Projectile|Pooling")
+    float MaxLifetime = 3.f;
+
+    // After a hit we wait a bit before recycling, to make sure the impact multicast is sent before the projectile is relaunched
+    UPROPERTY(EditAnywhere, Category = "Projectile|Pooling")
+    float RecycleDelayAfterHit = 1.f;
 };
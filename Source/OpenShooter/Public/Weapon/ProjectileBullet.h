@@ -8,14 +8,40 @@
 #include "ProjectileBullet.generated.h"
 
 /**
+ * A bullet that applies damage to the character it hits.
  *
+ * With server side rewind enabled, the server does not let the bullet collide with the characters' current pose. Instead, every
+ * tick it tests the distance travelled against the characters' hitboxes as the shooter was seeing them (rewound by the shooter's
+ * latency at the time the shot was fired).
  */
 UCLASS()
 class OPENSHOOTER_API AProjectileBullet : public AProjectile
 {
     GENERATED_BODY()
 
+public:
+    virtual void Tick(float DeltaTime) override;
+    virtual void SetFireTime(float InFireTime) override;
+
 protected:
+    virtual void BeginPlay() override;
+
     virtual void OnHit(UPrimitiveComponent* HitComponent, AActor* OtherActor, UPrimitiveComponent* OtherComponent,
         FVector NormalImpulse, const FHitResult& Hit) override;
+
+    virtual void OnLaunched() override;
+
+private:
+    UPROPERTY(EditAnywhere, Category = "Projectile|Lag Compensation")
+    bool bUseServerSideRewind = true;
+
+    // How far in the past the shooter was seeing the world when firing. Constant for the whole flight
+    float RewindDelay = 0.f;
+
+    FVector LastLocation;
+
+    void CheckRewoundHit();
+
+    // Tests LastLocation -> End against the hitboxes as the shooter was seeing them
+    bool TraceRewound(const FVector& End, FHitResult& OutHit) const;
 };
@@ -9,7 +9,7 @@
 
 class AProjectile;
 /**
- *
+ * A weapon that fires projectiles. The projectiles come from the UProjectilePoolSubsystem, so firing does not spawn actors.
  */
 UCLASS()
 class OPENSHOOTER_API AProjectileWeapon : public AWeapon
@@ -17,9 +17,19 @@ class OPENSHOOTER_API AProjectileWeapon : public AWeapon
     GENERATED_BODY()
 
 public:
-    virtual void Fire(const FVector& HitTarget) override;
+    virtual void Fire(const FVector& HitTarget, float FireTime, uint16 FireSequence) override;
+
+protected:
+    virtual void BeginPlay() override;
 
 private:
     UPROPERTY(EditAnywhere)
     TSubclassOf<AProjectile> ProjectileClass;
+
+    // The clients launch their own copy of the projectile (see AProjectile::bClientSimulated)
+    bool IsClientSimulated() const;
+
+    // How many projectiles of ProjectileClass this weapon makes sure are ready in the pool when it spawns
+    UPROPERTY(EditAnywhere, Category = "Weapon Properties")
+    int32 PoolPrewarmCount = 16;
 };
@@ -22,6 +22,33 @@ enum class EWeaponState : uint8
     EWS_MAX UMETA(DisplayName = "DefaultMax"),
 };
 
+// What the clients that do not own the weapon know about its magazine
+UENUM(BlueprintType)
+enum class EMagazineState : uint8
+{
+    EMS_Empty UMETA(DisplayName = "Empty"),
+    EMS_Partial UMETA(DisplayName = "Partial"),
+    EMS_Full UMETA(DisplayName = "Full"),
+
+    EMS_MAX UMETA(DisplayName = "DefaultMax"),
+};
+
+// Where a dropped weapon came to rest on the server, sent once before it goes dormant
+USTRUCT()
+struct FWeaponRestState
+{
+    GENERATED_BODY()
+
+    UPROPERTY()
+    FVector_NetQuantize Location;
+
+    UPROPERTY()
+    FRotator Rotation = FRotator::ZeroRotator;
+
+    UPROPERTY()
+    bool bAtRest = false;
+};
+
 UCLASS()
 class OPENSHOOTER_API AWeapon : public AActor
 {
@@ -60,6 +87,9 @@ public:
 
     void AddAmmo(int32 Amount);
 
+    // Server: the owner's shots up to FireSequence have been processed, the owning client can stop predicting them
+    void AcknowledgeFireSequence(uint16 FireSequence);
+
     UPROPERTY(EditAnywhere, Category = "Weapon Properties")
     USoundCue* EquipSound;
 
@@ -90,22 +120,52 @@ private:
     UPROPERTY(EditAnywhere)
     EWeaponType WeaponType;
 
+    // The ammo count confirmed by the server. Only the owner receives it, the others get MagazineState
     UPROPERTY(EditAnywhere, ReplicatedUsing = OnRep_Ammo, Category = "Weapon Properties")
     int32 Ammo;
 
     UPROPERTY(EditAnywhere, Category = "Weapon Properties")
     int32 MagCapacity;
 
+    UPROPERTY(Replicated)
+    EMagazineState MagazineState = EMagazineState::EMS_Full;
+
+    // Last fire sequence of the owner processed by the server (owner only)
+    UPROPERTY(ReplicatedUsing = OnRep_AckedFireSequence)
+    uint16 AckedFireSequence = 0;
+
+    // Owning client: the rounds spent locally that the server has not acknowledged yet
+    TArray<uint16, TInlineAllocator<16>> UnacknowledgedRounds;
+
     // Client function that updates the HUD when the ammo changes
     UFUNCTION()
     void OnRep_Ammo();
 
-    // Server Function that subtracts 1 to ammo and updates the HUD
-    void SpendRound();
+    UFUNCTION()
+    void OnRep_AckedFireSequence();
+
+    // Server: sets the ammo and the magazine state seen by the other clients
+    void SetAmmo(int32 NewAmmo);
+
+    // Subtracts 1 to ammo on the server, predicts it on the owning client, and updates the HUD
+    void SpendRound(uint16 FireSequence);
+
+    bool IsOwnedByLocalPlayer() const;
 
     // FireButtonPressed Animation
 public:
-    virtual void Fire(const FVector& HitTarget);
+    // FireTime is the server time at which the owning client fired (used for the server side rewind).
+    // FireSequence numbers the shots of the owner, for the ammo prediction and the scatter
+    virtual void Fire(const FVector& HitTarget, float FireTime, uint16 FireSequence);
+
+    // The random stream for the scatter of a shot, seeded with the owner's player id and the fire sequence. Every machine
+    // regenerates the same pattern from the HitTarget sent with the shot, so the pellets themselves are never replicated
+    FRandomStream MakeScatterStream(uint16 FireSequence) const;
+
+    // Random end point inside a sphere placed in front of the muzzle, in the direction of the target
+    FVector TraceEndWithScatter(const FVector& TraceStart, const FVector& HitTarget, FRandomStream& Stream) const;
+
+    FORCEINLINE bool UsesScatter() const { return bUseScatter || WeaponType == EWeaponType::EWT_Shotgun; }
 
 private:
     UPROPERTY(EditAnywhere, Category = "Weapon Properties")
@@ -123,6 +183,34 @@ private:
     UPROPERTY(VisibleAnywhere, ReplicatedUsing = OnRep_WeaponState, Category = "Weapon Properties")
     EWeaponState WeaponState;
 
+    // = Dormancy =
+    // A dropped weapon simulates its physics on every machine until it settles on the server. The server then sends where it
+    // stopped and makes the weapon dormant (DORM_DormantAll): it is not considered for replication anymore until it is picked
+    // up (woken up) or its ammo changes (flushed)
+
+    UPROPERTY(ReplicatedUsing = OnRep_RestState)
+    FWeaponRestState RestState;
+
+    UFUNCTION()
+    void OnRep_RestState();
+
+    // Clients: snap to the server rest transform once the weapon is dropped and at rest
+    void ApplyRestState();
+
+    // Server: polls the physics of the dropped weapon until it sleeps (or MaxSettleTime)
+    void CheckIfSettled();
+    void GoDormant();
+
+    FTimerHandle SettleTimer;
+    float SettleTime = 0.f;
+
+    UPROPERTY(EditAnywhere, Category = "Weapon Properties|Dormancy")
+    float SettleCheckInterval = 0.5f;
+
+    // Goes dormant after this time even if the physics never sleeps (seconds)
+    UPROPERTY(EditAnywhere, Category = "Weapon Properties|Dormancy")
+    float MaxSettleTime = 5.f;
+
     // Zoomed FOV while aiming
     UPROPERTY(EditAnywhere, Category = "Weapon Properties")
     float ZoomedFOV = 30.f;
@@ -136,6 +224,17 @@ private:
     UPROPERTY(EditAnywhere, Category = "Weapon Properties")
     float FireDelay = 0.15f;
 
+    // = Scatter (always on for shotguns) =
+
+    UPROPERTY(EditAnywhere, Category = "Weapon Properties|Scatter")
+    bool bUseScatter = false;
+
+    UPROPERTY(EditAnywhere, Category = "Weapon Properties|Scatter")
+    float DistanceToSphere = 800.f;
+
+    UPROPERTY(EditAnywhere, Category = "Weapon Properties|Scatter")
+    float SphereRadius = 75.f;
+
 public:
     FORCEINLINE USphereComponent* GetAreaSphere() const { return AreaSphere; }
     FORCEINLINE UMeshComponent* GetMesh() const { return WeaponMesh; }
@@ -147,8 +246,9 @@ public:
     FORCEINLINE EWeaponType GetWeaponType() const { return WeaponType; }
     FORCEINLINE float GetFireDelay() const { return FireDelay; }
 
-    FORCEINLINE bool IsEmpty() const { return Ammo <= 0; }
-    FORCEINLINE int32 GetAmmo() const { return Ammo; }
+    // Predicted on the owning client, authoritative on the server. Not known by the other clients (see IsEmpty)
+    FORCEINLINE int32 GetAmmo() const { return FMath::Max(Ammo - UnacknowledgedRounds.Num(), 0); }
+    bool IsEmpty() const;
     FORCEINLINE int32 GetMagCapacity() const { return MagCapacity; }
 
     // Just for caching
@@ -11,5 +11,7 @@ public class OpenShooterEditorTarget : TargetRules
         DefaultBuildSettings = BuildSettingsVersion.V5;
         IncludeOrderVersion = EngineIncludeOrderVersion.Unreal5_4;
         ExtraModuleNames.Add("OpenShooter");
+
+        bWithPushModel = true;    // lets us mark replicated properties dirty instead of comparing them every update
     }
 }